@@ -0,0 +1,187 @@
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+#include "common.hpp"
+
+// Cross-core cost of the shared table layout. Worker processes (one per
+// seat, like forked handlers) hammer their own fields in a shared mapping,
+// once with the packed pre-alignment Table and once with the current
+// cache-line-aligned one:
+//
+//   seat   every seat of every table advances its own dice stream
+//          (per-player hot fields, no lock)
+//   table  one worker per table takes its game_mutex, moves a position,
+//          and bumps the broadcast counters (neighbouring tables)
+//
+// Layout effects only show with workers on different cores; with fewer
+// cores than workers the numbers mostly measure time slicing.
+
+/* ========================================
+   PACKED LAYOUT - Table Before Alignment
+   ======================================== */
+struct PackedDice {
+    uint64_t s[4];
+    uint8_t batch[DICE_BATCH];
+    int next;
+};
+
+struct PackedTable {
+    int id;
+    GameState game;
+    Player players[MAX_PLAYERS];
+    pthread_mutex_t game_mutex;
+    pthread_cond_t turn_cond;
+    uint64_t game_number;
+    uint64_t game_seed;
+    PackedDice dice[MAX_PLAYERS];
+    long long turn_committed_ns;
+    long long handoff_total_ns;
+    long long handoff_max_ns;
+    int handoff_count;
+    BroadcastStats broadcast;
+};
+
+/* ========================================
+   WORKERS
+   ======================================== */
+struct Control {
+    alignas(CACHE_LINE) std::atomic<int> ready;
+    alignas(CACHE_LINE) std::atomic<int> go;
+    alignas(CACHE_LINE) std::atomic<int> stop;
+    alignas(CACHE_LINE) long long ops[MAX_TABLES];   // per worker, written once at exit
+};
+
+template <typename TableT>
+long long seat_worker(TableT* table, int seat, Control* ctl) {
+    long long ops = 0;
+    while (!ctl->stop.load(std::memory_order_relaxed)) {
+        for (int i = 0; i < 64; i++) {
+            xoshiro_next(table->dice[seat].s);
+            table->dice[seat].next = (table->dice[seat].next + 1) & (DICE_BATCH - 1);
+        }
+        ops += 64;
+    }
+    return ops;
+}
+
+template <typename TableT>
+long long table_worker(TableT* table, Control* ctl) {
+    long long ops = 0;
+    while (!ctl->stop.load(std::memory_order_relaxed)) {
+        for (int i = 0; i < 64; i++) {
+            pthread_mutex_lock(&table->game_mutex);
+            table->game.positions[0]++;
+            table->turn_committed_ns = ops + i;
+            pthread_mutex_unlock(&table->game_mutex);
+            __atomic_add_fetch(&table->broadcast.broadcasts, 1, __ATOMIC_RELAXED);
+            __atomic_add_fetch(&table->broadcast.bytes, 64, __ATOMIC_RELAXED);
+        }
+        ops += 64;
+    }
+    return ops;
+}
+
+// Run one configuration; returns total operations per second
+template <typename TableT>
+double run(bool seat_mode, int num_tables, int num_players, int duration_ms) {
+    size_t tables_size = sizeof(TableT) * num_tables;
+    void* mem = mmap(nullptr, tables_size + sizeof(Control), PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+
+    TableT* tables = static_cast<TableT*>(mem);
+    Control* ctl = new (static_cast<char*>(mem) + tables_size) Control();
+    for (int t = 0; t < num_tables; t++) {
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        pthread_mutex_init(&tables[t].game_mutex, &attr);
+        pthread_mutexattr_destroy(&attr);
+    }
+
+    int workers = seat_mode ? num_tables * num_players : num_tables;
+    for (int w = 0; w < workers; w++) {
+        if (fork() == 0) {
+            ctl->ready.fetch_add(1);
+            while (!ctl->go.load()) sched_yield();
+
+            ctl->ops[w] = seat_mode
+                ? seat_worker(&tables[w / num_players], w % num_players, ctl)
+                : table_worker(&tables[w], ctl);
+            _exit(0);
+        }
+    }
+
+    while (ctl->ready.load() < workers) sched_yield();
+    long long start = monotonic_ns();
+    ctl->go.store(1);
+    usleep(duration_ms * 1000);
+    ctl->stop.store(1);
+    while (wait(nullptr) > 0);
+    double elapsed = (monotonic_ns() - start) / 1e9;
+
+    long long total = 0;
+    for (int w = 0; w < workers; w++) total += ctl->ops[w];
+    munmap(mem, tables_size + sizeof(Control));
+    return total / elapsed;
+}
+
+void report(const char* mode, bool seat_mode, int tables, int players, int duration_ms) {
+    double packed = run<PackedTable>(seat_mode, tables, players, duration_ms);
+    double padded = run<Table>(seat_mode, tables, players, duration_ms);
+
+    std::cout << " " << std::left << std::setw(6) << mode << std::right
+              << std::setw(7) << tables << std::setw(8) << players
+              << std::setw(12) << packed / 1e6 << std::setw(12) << padded / 1e6
+              << std::setw(8) << std::setprecision(2) << padded / packed << "x\n"
+              << std::setprecision(1);
+}
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [-T max tables] [-d ms per run]\n";
+}
+
+/* ========================================
+   MAIN
+   ======================================== */
+int main(int argc, char* argv[]) {
+    int max_tables = 8;
+    int duration_ms = 200;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "T:d:")) != -1) {
+        switch (opt) {
+        case 'T': max_tables = atoi(optarg); break;
+        case 'd': duration_ms = atoi(optarg); break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+
+    if (max_tables < 1 || max_tables * MAX_PLAYERS > MAX_TABLES || duration_ms < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Layout contention: " << sysconf(_SC_NPROCESSORS_ONLN) << " CPU(s), sizeof "
+              << sizeof(PackedTable) << " -> " << sizeof(Table) << " bytes per table\n";
+    std::cout << " mode   tables players  packed M/s  padded M/s  speedup\n";
+
+    for (int players = 1; players <= MAX_PLAYERS; players += 2)
+        report("seat", true, 1, players, duration_ms);
+    for (int tables = 2; tables <= max_tables; tables *= 2)
+        report("seat", true, tables, 3, duration_ms);
+    for (int tables = 1; tables <= max_tables; tables *= 2)
+        report("table", false, tables, 1, duration_ms);
+
+    return 0;
+}
@@ -0,0 +1,509 @@
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+#include "protocol.hpp"
+#include "race_rules.hpp"
+#include "race_track.hpp"
+#include "score_store.hpp"
+
+#ifndef BENCH_TOLERANCE
+#define BENCH_TOLERANCE 1.5        // set at build time: make BENCH_TOLERANCE=2
+#endif
+
+// Microbenchmarks for the server's hot pieces, each run in isolation:
+//
+//   track_render       RaceTrack frame for one roll (STATE/spectator frames)
+//   leaderboard        ranking update and console leaderboard text for one roll
+//   log_handoff        one entry pushed by a forked producer and written out
+//                      by a consumer thread draining the ring (logger path)
+//   score_append       one group commit of 1 win (write + fdatasync)
+//   score_append_32    one group commit of 32 wins
+//   score_save         snapshot of 1000 totals (write, fsync, rename)
+//   score_load         snapshot of 1000 totals plus a 1000-record journal
+//   mutex_handoff      game_mutex + turn_seq handoff between two processes
+//   fifo_round_trip    message to a forked echo process over FIFOs and back
+//
+// Each benchmark runs -r times and reports its median in ns per operation.
+// Results can be written as a baseline (-w) and later compared with one
+// (-b): anything slower than baseline * tolerance is flagged and the exit
+// status is 2. Baselines are per machine; record one before a change and
+// compare after it (make bench-baseline, make bench). A baseline names the
+// machine and build it was recorded on; against any other the comparison
+// is skipped rather than flagging the hardware difference.
+
+/* ========================================
+   BENCHMARKS - ns per Operation for One Run
+   ======================================== */
+double elapsed_per_op(long long start, long ops) {
+    return static_cast<double>(monotonic_ns() - start) / ops;
+}
+
+// Positions cycle through a precomputed set so every frame differs
+double bench_track_render(long ops) {
+    std::mt19937 rng(1);
+    std::vector<int> positions(1024 * MAX_PLAYERS);
+    for (int& p : positions) p = rng() % (WIN_POSITION + 1);
+
+    RaceTrack<WIN_POSITION> track;
+    size_t bytes = 0;
+    long long start = monotonic_ns();
+    for (long i = 0; i < ops; i++)
+        bytes += track.render(&positions[(i & 1023) * MAX_PLAYERS], MAX_PLAYERS).size();
+    double ns = elapsed_per_op(start, ops);
+
+    if (bytes == 0) std::cerr << "track_render: empty frames\n";
+    return ns;
+}
+
+// A full table racing: each op one seat moves, as in commit_roll
+double bench_leaderboard(long ops) {
+    std::mt19937 rng(2);
+    std::vector<int> rolls(1024);
+    for (int& roll : rolls) roll = rng() % 6 + 1;
+
+    int positions[MAX_PLAYERS] = {};
+    Ranking ranking;
+    ranking_reset(&ranking, MAX_PLAYERS);
+
+    char text[LEADERBOARD_TEXT_MAX];
+    size_t bytes = 0;
+    long long start = monotonic_ns();
+    for (long i = 0, seat = 0; i < ops; i++, seat = race_next_seat(seat, MAX_PLAYERS)) {
+        positions[seat] = (positions[seat] + rolls[i & 1023]) % (WIN_POSITION + 1);
+        ranking_update(&ranking, positions, MAX_PLAYERS, seat);
+        bytes += format_leaderboard(text, positions, ranking.order, MAX_PLAYERS);
+    }
+    double ns = elapsed_per_op(start, ops);
+
+    if (bytes == 0) std::cerr << "leaderboard: empty text\n";
+    return ns;
+}
+
+// Producer in a forked process (like a handler), consumer here sleeping
+// on the ring's semaphore and draining to /dev/null (like logger_thread)
+double bench_log_handoff(long ops) {
+    void* mem = mmap(nullptr, sizeof(LogRing), PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+    LogRing* ring = new (mem) LogRing;
+    log_ring_init(ring);
+    int sink = open("/dev/null", O_WRONLY);
+
+    long long start = monotonic_ns();
+    pid_t producer = fork();
+    if (producer == 0) {
+        for (long i = 0; i < ops; i++) {
+            while (!log_ring_push(ring, "Table %d: Player %d rolled %d (position=%d)",
+                                  static_cast<int>(i & 255), static_cast<int>(i % MAX_PLAYERS),
+                                  static_cast<int>(i % 6 + 1), static_cast<int>(i % WIN_POSITION)))
+                sched_yield();   // ring full: the logger is behind
+        }
+        _exit(0);
+    }
+
+    long drained = 0;
+    while (drained < ops) {
+        if (sem_wait(&ring->wakeup) < 0) continue;
+        do {
+            drained += log_ring_drain(ring, sink);
+        } while (sem_trywait(&ring->wakeup) == 0);
+    }
+    double ns = elapsed_per_op(start, ops);
+
+    waitpid(producer, nullptr, 0);
+    close(sink);
+    sem_destroy(&ring->wakeup);
+    munmap(mem, sizeof(LogRing));
+    return ns;
+}
+
+// The score benchmarks run in a scratch directory (see main), so the
+// store's fixed file names never touch a real scores.txt
+void score_fill(ScoreStore* store, int names) {
+    for (int i = 0; i < names; i++)
+        store->wins["player" + std::to_string(i)] = i + 1;
+    store->seq = names;
+}
+
+bool score_open_journal(ScoreStore* store) {
+    store->journal_fd = open(SCORE_JOURNAL_PATH, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (store->journal_fd < 0) {
+        perror("open scores.journal");
+        return false;
+    }
+    store->journal_size = 0;
+    return true;
+}
+
+double score_append_batches(long ops, int batch) {
+    ScoreStore store;
+    if (!score_open_journal(&store)) exit(1);
+
+    std::vector<ScoreEvent> events(batch);
+    for (int i = 0; i < batch; i++)
+        snprintf(events[i].name, MAX_NAME_LEN, "player%d", i);
+
+    long long start = monotonic_ns();
+    for (long i = 0; i < ops; i++) score_store_append(&store, events.data(), batch);
+    double ns = elapsed_per_op(start, ops);
+
+    close(store.journal_fd);
+    return ns;
+}
+
+double bench_score_append(long ops) {
+    return score_append_batches(ops, 1);
+}
+
+double bench_score_append_32(long ops) {
+    return score_append_batches(ops, 32);
+}
+
+double bench_score_save(long ops) {
+    ScoreStore store;
+    if (!score_open_journal(&store)) exit(1);
+    score_fill(&store, 1000);
+
+    long long start = monotonic_ns();
+    for (long i = 0; i < ops; i++) score_store_compact(&store);
+    double ns = elapsed_per_op(start, ops);
+
+    close(store.journal_fd);
+    return ns;
+}
+
+double bench_score_load(long ops) {
+    // A snapshot of 1000 totals and a journal of 1000 newer wins
+    ScoreStore seed;
+    if (!score_open_journal(&seed)) exit(1);
+    score_fill(&seed, 1000);
+    score_store_compact(&seed);
+
+    std::vector<ScoreEvent> events(1000);
+    for (int i = 0; i < 1000; i++)
+        snprintf(events[i].name, MAX_NAME_LEN, "player%d", i);
+    score_store_append(&seed, events.data(), 1000);
+    close(seed.journal_fd);
+
+    long long start = monotonic_ns();
+    for (long i = 0; i < ops; i++) {
+        ScoreStore store;
+        store.seq = score_load_snapshot(&store, SCORE_SNAPSHOT_PATH);
+        if (score_replay_journal(&store, SCORE_JOURNAL_PATH) != 1000) {
+            std::cerr << "score_load: journal replay came up short\n";
+            exit(1);
+        }
+    }
+    return elapsed_per_op(start, ops);
+}
+
+// Two processes take turns the way forked handlers do: wait on turn_seq,
+// take game_mutex, pass the turn, wake the other one
+double bench_mutex_handoff(long ops) {
+    void* mem = mmap(nullptr, sizeof(Table), PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+    Table* table = static_cast<Table*>(mem);
+
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&table->game_mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+    table->game.current_turn = 0;
+
+    auto play = [table](int me, long turns) {
+        for (long i = 0; i < turns; i++) {
+            pthread_mutex_lock(&table->game_mutex);
+            while (table->game.current_turn != me) {
+                uint32_t seen = table->turn_seq.load(std::memory_order_acquire);
+                pthread_mutex_unlock(&table->game_mutex);
+                seq_wait(&table->turn_seq, seen, 1000);
+                pthread_mutex_lock(&table->game_mutex);
+            }
+            table->game.current_turn = 1 - me;
+            turn_wake(table);
+            pthread_mutex_unlock(&table->game_mutex);
+        }
+    };
+
+    long turns = (ops + 1) / 2;
+    long long start = monotonic_ns();
+    pid_t other = fork();
+    if (other == 0) {
+        play(1, turns);
+        _exit(0);
+    }
+    play(0, turns);
+    waitpid(other, nullptr, 0);
+    double ns = elapsed_per_op(start, turns * 2);
+
+    munmap(mem, sizeof(Table));
+    return ns;
+}
+
+// ROLL to a forked echo process over one FIFO, answered over another
+double bench_fifo_round_trip(long ops) {
+    const char* ping = "bench_ping.fifo";
+    const char* pong = "bench_pong.fifo";
+    unlink(ping);
+    unlink(pong);
+    if (mkfifo(ping, 0600) < 0 || mkfifo(pong, 0600) < 0) {
+        perror("mkfifo");
+        exit(1);
+    }
+
+    pid_t echo = fork();
+    if (echo == 0) {
+        int in = open(ping, O_RDONLY);
+        int out = open(pong, O_WRONLY);
+        MsgReader<4096> reader;
+        MsgView msg;
+        while (reader.fill(in) > 0) {
+            while (reader.next(msg)) send_msg(out, MSG_YOUR_TURN);
+        }
+        _exit(0);
+    }
+
+    int out = open(ping, O_WRONLY);
+    int in = open(pong, O_RDONLY);
+    MsgReader<4096> reader;
+    MsgView msg;
+
+    long long start = monotonic_ns();
+    for (long i = 0; i < ops; i++) {
+        send_msg(out, MSG_ROLL);
+        while (!reader.next(msg)) {
+            if (reader.fill(in) <= 0) {
+                std::cerr << "fifo_round_trip: echo process went away\n";
+                exit(1);
+            }
+        }
+    }
+    double ns = elapsed_per_op(start, ops);
+
+    close(out);
+    close(in);
+    waitpid(echo, nullptr, 0);
+    unlink(ping);
+    unlink(pong);
+    return ns;
+}
+
+struct Bench {
+    const char* name;
+    double (*run)(long ops);
+    long ops;                  // per run, sized for roughly 50-200 ms
+};
+
+const Bench BENCHES[] = {
+    { "track_render",    bench_track_render,    2000000 },
+    { "leaderboard",     bench_leaderboard,     500000 },
+    { "log_handoff",     bench_log_handoff,     200000 },
+    { "score_append",    bench_score_append,    200 },
+    { "score_append_32", bench_score_append_32, 200 },
+    { "score_save",      bench_score_save,      50 },
+    { "score_load",      bench_score_load,      200 },
+    { "mutex_handoff",   bench_mutex_handoff,   50000 },
+    { "fifo_round_trip", bench_fifo_round_trip, 20000 },
+};
+
+/* ========================================
+   BASELINE - "<name> <ns per op>" Lines
+   ======================================== */
+constexpr const char* MACHINE_TAG = "# machine: ";
+
+// CPUs, CPU model and the build's table shape: what the numbers depend on
+std::string machine_id() {
+    std::string model = "unknown CPU";
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        size_t colon = line.find(':');
+        if (line.compare(0, 10, "model name") == 0 && colon != std::string::npos) {
+            model = line.substr(line.find_first_not_of(" \t", colon + 1));
+            break;
+        }
+    }
+    return std::to_string(sysconf(_SC_NPROCESSORS_ONLN)) + " x " + model + ", goal " +
+           std::to_string(WIN_POSITION) + "m, " + std::to_string(MAX_PLAYERS) + " seats";
+}
+
+// Baseline results by benchmark name; *machine gets the machine it was
+// recorded on ("" for a file without one)
+std::map<std::string, double> load_baseline(const char* path, std::string* machine) {
+    std::map<std::string, double> baseline;
+    std::ifstream in(path);
+    if (!in) {
+        perror(path);
+        return baseline;
+    }
+
+    std::string line;
+    size_t tag = strlen(MACHINE_TAG);
+    while (std::getline(in, line)) {
+        if (line.compare(0, tag, MACHINE_TAG) == 0) *machine = line.substr(tag);
+        if (line.empty() || line[0] == '#') continue;
+        char name[64];
+        double ns;
+        if (sscanf(line.c_str(), "%63s %lf", name, &ns) == 2) baseline[name] = ns;
+    }
+    return baseline;
+}
+
+bool save_baseline(const char* path, const std::vector<double>& results) {
+    std::ofstream out(path);
+    if (!out) {
+        perror(path);
+        return false;
+    }
+
+    out << "# bench_micro baseline: <benchmark> <median ns per op>\n";
+    out << MACHINE_TAG << machine_id() << "\n";
+    out << std::fixed << std::setprecision(1);
+    for (size_t i = 0; i < results.size(); i++)
+        out << BENCHES[i].name << " " << results[i] << "\n";
+    return static_cast<bool>(out);
+}
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [-r runs] [-b baseline] [-w baseline] [-x tolerance] [-j]\n"
+              << "  -r  runs per benchmark, the median is reported (default 5)\n"
+              << "  -b  compare with a baseline file, exit 2 if anything regressed\n"
+              << "  -w  write the results as a new baseline file\n"
+              << "  -x  slowdown flagged as a regression (default " << BENCH_TOLERANCE << ")\n"
+              << "  -j  print results as JSON instead of text\n";
+}
+
+/* ========================================
+   MAIN
+   ======================================== */
+int main(int argc, char* argv[]) {
+    int runs = 5;
+    const char* baseline_path = nullptr;
+    const char* write_path = nullptr;
+    double tolerance = BENCH_TOLERANCE;
+    bool json = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "r:b:w:x:j")) != -1) {
+        switch (opt) {
+        case 'r': runs = atoi(optarg); break;
+        case 'b': baseline_path = optarg; break;
+        case 'w': write_path = optarg; break;
+        case 'x': tolerance = atof(optarg); break;
+        case 'j': json = true; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+
+    if (runs < 1 || tolerance < 1.0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // A missing baseline, or one from another machine, is reported and
+    // the results are shown without a comparison
+    std::map<std::string, double> baseline;
+    if (baseline_path) {
+        std::string recorded_on;
+        baseline = load_baseline(baseline_path, &recorded_on);
+        std::string machine = machine_id();
+        if (!baseline.empty() && recorded_on != machine) {
+            std::cerr << "Baseline " << baseline_path << " was recorded on "
+                      << (recorded_on.empty() ? "an unknown machine" : recorded_on)
+                      << ", this is " << machine << "\n";
+            baseline.clear();
+        }
+        if (baseline.empty()) {
+            std::cerr << "Skipping the comparison: record a baseline here first"
+                      << " (make bench-baseline)\n";
+            baseline_path = nullptr;
+        }
+    }
+
+    // Score files and FIFOs go in a scratch directory under the current
+    // one, so fdatasync hits the same file system the server would use
+    char scratch[] = "bench_scratch.XXXXXX";
+    if (!mkdtemp(scratch) || chdir(scratch) < 0) {
+        perror("bench scratch directory");
+        return 1;
+    }
+
+    std::vector<double> results;
+    for (const Bench& bench : BENCHES) {
+        std::vector<double> samples;
+        for (int r = 0; r < runs; r++) samples.push_back(bench.run(bench.ops));
+        std::sort(samples.begin(), samples.end());
+        results.push_back(samples[samples.size() / 2]);
+    }
+
+    unlink(SCORE_SNAPSHOT_PATH);
+    unlink(SCORE_JOURNAL_PATH);
+    if (chdir("..") < 0 || rmdir(scratch) < 0) perror("remove bench scratch directory");
+
+    int regressions = 0;
+    if (json) std::cout << "{\"runs\":" << runs << ",\"tolerance\":" << tolerance
+                        << ",\"results\":[";
+    else std::cout << " benchmark          ns/op     baseline    ratio\n";
+
+    for (size_t i = 0; i < results.size(); i++) {
+        auto base = baseline.find(BENCHES[i].name);
+        bool have_base = base != baseline.end() && base->second > 0;
+        double ratio = have_base ? results[i] / base->second : 0.0;
+        bool slower = have_base && ratio > tolerance;
+        regressions += slower;
+
+        if (json) {
+            std::cout << (i ? "," : "") << std::fixed << std::setprecision(1)
+                      << "{\"name\":\"" << BENCHES[i].name << "\",\"ns_per_op\":" << results[i];
+            if (have_base)
+                std::cout << ",\"baseline_ns\":" << base->second << std::setprecision(3)
+                          << ",\"ratio\":" << ratio << ",\"regression\":"
+                          << (slower ? "true" : "false");
+            std::cout << "}";
+            continue;
+        }
+
+        std::cout << " " << std::left << std::setw(16) << BENCHES[i].name << std::right
+                  << std::fixed << std::setprecision(1) << std::setw(11) << results[i];
+        if (have_base)
+            std::cout << std::setw(13) << base->second << std::setprecision(2)
+                      << std::setw(8) << ratio << "x" << (slower ? "  SLOWER" : "");
+        else if (baseline_path)
+            std::cout << "          (not in baseline)";
+        std::cout << "\n";
+    }
+
+    if (json) std::cout << "],\"regressions\":" << regressions << "}\n";
+    else if (regressions)
+        std::cout << " " << regressions << " regression(s) beyond " << tolerance << "x baseline\n";
+    else if (baseline_path)
+        std::cout << " No regressions beyond " << tolerance << "x baseline\n";
+
+    if (write_path && !save_baseline(write_path, results)) return 1;
+    return regressions ? 2 : 0;
+}
@@ -0,0 +1,95 @@
+#ifndef BROADCAST_HPP
+#define BROADCAST_HPP
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "common.hpp"
+#include "metrics.hpp"
+#include "out_queue.hpp"
+#include "protocol.hpp"
+
+// ---- Broadcast Channel ----
+// Long-lived descriptors for every seat's out FIFO at one table, with an
+// outbound queue per seat (out_queue.hpp). Opened once by the reactor that
+// owns the table (O_RDWR so the open never blocks and survives client
+// restarts), which is then the only writer to them. Socket seats put
+// their socket in fds[].
+struct BroadcastChannel {
+    int fds[MAX_PLAYERS];
+    int count;
+    OutQueue out[MAX_PLAYERS];
+    SeatMask<MAX_PLAYERS> stuck;   // seats whose queue overflowed or whose socket failed
+};
+
+inline bool channel_open(BroadcastChannel* ch, int table_id, int num_players) {
+    ch->count = 0;
+    ch->stuck.clear();
+    for (int i = 0; i < num_players; i++) {
+        int fd = open(fifo_path(table_id, i, "out").c_str(), O_RDWR | O_NONBLOCK);
+        if (fd < 0) return false;
+        ch->fds[ch->count++] = fd;
+    }
+    return true;
+}
+
+inline void channel_close(BroadcastChannel* ch) {
+    for (int i = 0; i < ch->count; i++) {
+        close(ch->fds[i]);
+        out_reset(&ch->out[i]);
+    }
+    ch->count = 0;
+}
+
+// One frame to one seat through its queue. Returns the bytes written now.
+inline ssize_t channel_send_to(BroadcastChannel* ch, int seat, const iovec* iov, int iovcnt,
+                               bool state) {
+    ssize_t n = out_send(&ch->out[seat], ch->fds[seat], iov, iovcnt, state);
+    if (n < 0) {
+        ch->stuck.set(seat);
+        return 0;
+    }
+    return n;
+}
+
+// Control message to one seat, never dropped while the seat is there
+inline void channel_send_msg(BroadcastChannel* ch, int seat, MsgType type,
+                             const void* payload = nullptr, uint32_t length = 0) {
+    if (ch->fds[seat] < 0) return;
+    if (!out_send_msg(&ch->out[seat], ch->fds[seat], type, payload, length)) ch->stuck.set(seat);
+}
+
+// Hand the same immutable frame (one or more iovecs, rendered once) to every
+// recipient except seats set in `skip`: written straight away with one
+// writev() each, or queued behind what a slow recipient has not taken yet.
+// `state`: a STATE frame, which replaces an older one still queued.
+// Counters go to the table's shared stats and the calling thread's metrics slot.
+inline void channel_send(BroadcastChannel* ch, BroadcastStats* stats, const iovec* iov,
+                         int iovcnt, const SeatMask<MAX_PLAYERS>* skip = nullptr,
+                         bool state = false) {
+    size_t frame_len = 0;
+    for (int i = 0; i < iovcnt; i++) frame_len += iov[i].iov_len;
+
+    long long bytes = 0, behind = 0, writes = 0;
+    for (int i = 0; i < ch->count; i++) {
+        if ((skip && skip->test(i)) || ch->fds[i] < 0) continue;   // seat empty (socket tables)
+        bool queued = out_pending(&ch->out[i]);
+        ssize_t n = channel_send_to(ch, i, iov, iovcnt, state);
+        bytes += n;
+        if (queued || n < static_cast<ssize_t>(frame_len)) behind++;
+        if (!queued) writes++;
+    }
+
+    __atomic_add_fetch(&stats->broadcasts, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->syscalls, writes, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->bytes, bytes, __ATOMIC_RELAXED);
+    if (behind) __atomic_add_fetch(&stats->drops, behind, __ATOMIC_RELAXED);
+
+    metric_add(&t_metrics->broadcast_frames);
+    metric_add(&t_metrics->broadcast_bytes, bytes);
+    if (behind) metric_add(&t_metrics->fifo_eagain, behind);
+}
+
+#endif
@@ -1,62 +1,351 @@
-#include <iostream>
-#include <fcntl.h>
-#include <unistd.h>
-#include <cstring>
-#include <cstdlib>
-
-int main() {
-    int player_id;
-    std::cout << "Enter player ID (0-4 for up to 5 players): ";
-    std::cin >> player_id;
-    
-    if (player_id < 0 || player_id > 4) {
-        std::cerr << "Invalid player ID (must be 0-4)\n";
-        return 1;
-    }
-
-    std::string in_fifo  = "/tmp/player_" + std::to_string(player_id) + "_out";
-    std::string out_fifo = "/tmp/player_" + std::to_string(player_id) + "_in";
-
-    int fd_in  = open(in_fifo.c_str(), O_RDONLY);
-    int fd_out = open(out_fifo.c_str(), O_WRONLY);
-
-    if (fd_in < 0 || fd_out < 0) {
-        perror("FIFO open");
-        return 1;
-    }
-
-    std::cout << "✅ Connected as Player " << player_id << "\n";
-    std::cout << "Waiting for game to start...\n";
-
-    char buffer[2048];
-    // bool game_over = false;
-
-    while (true) {
-        std::memset(buffer, 0, sizeof(buffer));
-        ssize_t bytes = read(fd_in, buffer, sizeof(buffer));
-        if (bytes <= 0) break;
-
-        std::cout << "\033[2J\033[H";
-        std::cout << buffer;
-
-        if (std::strncmp(buffer, "YOUR_TURN", 9) == 0) {
-            std::cout << "\n🎲 Your turn! Press ENTER to roll dice...";
-            std::cin.ignore();
-            std::cin.get();
-            write(fd_out, "ROLL\n", 5);
-        }
-        else if (std::strncmp(buffer, "YOU_WIN", 7) == 0) {
-            std::cout << "\n🎉🎉🎉 YOU WIN! 🎉🎉🎉\n";
-            std::cout << "Waiting for next game...\n";
-            continue;
-        }
-        else if (std::strncmp(buffer, "GAME_OVER", 9) == 0) {
-            std::cout << "Game over. Waiting for next game...\n";
-        }
-    }
-
-    close(fd_in);
-    close(fd_out);
-    return 0;
-}
-
+#include <iostream>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#include "common.hpp"
+#include "protocol.hpp"
+#include "race_track.hpp"
+
+// Spectator mode: watch a table without taking a seat
+int watch_table(int table_id) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, SPECTATOR_SOCKET, sizeof(addr.sun_path) - 1);
+
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        perror("connect spectator socket");
+        return 1;
+    }
+
+    WatchMsg watch{table_id};
+    send_msg(fd, MSG_WATCH, &watch, sizeof(watch));
+
+    static MsgReader<MAX_PAYLOAD + sizeof(MsgHeader)> reader;
+    MsgView msg;
+
+    while (reader.fill(fd) > 0) {
+        while (reader.next(msg)) {
+            if (msg.type != MSG_SNAPSHOT || msg.length < sizeof(SnapshotMsg)) continue;
+
+            SnapshotMsg snap;
+            std::memcpy(&snap, msg.payload, sizeof(snap));
+            size_t skip = sizeof(snap) + snap.num_players * sizeof(int32_t);
+            if (msg.length < skip) continue;
+
+            std::cout << "\033[2J\033[H";
+            std::cout << "👀 Spectating table " << snap.table_id << " (update "
+                      << snap.version << ")";
+            if (snap.winner >= 0) std::cout << " - Player " << snap.winner << " won!";
+            else if (snap.game_active) std::cout << " - Player " << snap.current_turn << " to roll";
+            std::cout << "\n";
+            std::cout.write(msg.payload + skip, msg.length - skip);
+            std::cout.flush();
+        }
+        if (reader.error) break;
+    }
+
+    std::cout << "Server closed the spectator connection\n";
+    close(fd);
+    return 0;
+}
+
+/* ========================================
+   SHARED-MEMORY VIEW - Render from the Mapped Table
+   ======================================== */
+
+// With -m the client maps its table read-only and redraws whenever the
+// table's state sequence moves, sleeping on it as a futex in between. The
+// server then sends this seat only prompts and game-over messages; the
+// track is never pushed through the FIFO.
+std::mutex g_screen_mutex;
+std::atomic<bool> g_done{false};
+
+const Table* map_table(int table_id) {
+    int fd = shm_open(TABLES_SHM_NAME, O_RDONLY, 0);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        perror("shm_open tables");
+        return nullptr;
+    }
+
+    // The mapping must start on a page boundary; tables need not
+    off_t offset = static_cast<off_t>(table_id) * sizeof(Table);
+    off_t page_start = offset & ~static_cast<off_t>(sysconf(_SC_PAGESIZE) - 1);
+    size_t length = offset - page_start + sizeof(Table);
+    if (offset + static_cast<off_t>(sizeof(Table)) > st.st_size) {
+        std::cerr << "Table " << table_id << " does not exist\n";
+        close(fd);
+        return nullptr;
+    }
+
+    void* mem = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, page_start);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        perror("mmap table");
+        return nullptr;
+    }
+    return reinterpret_cast<const Table*>(static_cast<const char*>(mem) + (offset - page_start));
+}
+
+void render_loop(const Table* table, int player_id) {
+    RaceTrack<WIN_POSITION> track_renderer;
+    uint32_t shown = 0;
+    while (!g_done) {
+        GameState state;
+        uint32_t version = table_snapshot(table, &state);
+
+        if (version != shown) {
+            std::string_view track = track_renderer.render(state.positions, state.num_players);
+            bool my_turn = state.game_active && !state.game_over && !state.turn_complete &&
+                           state.current_turn == player_id;
+
+            std::lock_guard<std::mutex> lock(g_screen_mutex);
+            std::cout << "\033[2J\033[H" << track;
+            if (my_turn) std::cout << "\n🎲 Your turn! Press ENTER to roll dice...";
+            std::cout.flush();
+            shown = version;
+        }
+
+        // Woken by the server on every state change; the timeout only
+        // covers the moments before it has seen MSG_SHM_VIEW
+        table_wait(table, version, 1000);
+    }
+}
+
+/* ========================================
+   JOINING - Player Socket or Fixed-Seat FIFOs
+   ======================================== */
+
+// Ask the listener for a seat. Returns the socket (used both ways) or -1.
+int join_socket(const char* name, int* table_id, int* player_id) {
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, PLAYER_SOCKET, sizeof(addr.sun_path) - 1);
+
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        perror("connect player socket");
+        return -1;
+    }
+
+    send_msg(fd, MSG_JOIN, name, name ? strlen(name) : 0);
+
+    MsgReader<256> reader;
+    MsgView msg;
+    if (reader.fill(fd) <= 0 || !reader.next(msg) || msg.type != MSG_WELCOME ||
+        msg.length < sizeof(WelcomeMsg)) {
+        std::cerr << "Server refused the join\n";
+        close(fd);
+        return -1;
+    }
+
+    WelcomeMsg welcome;
+    std::memcpy(&welcome, msg.payload, sizeof(welcome));
+    *table_id = welcome.table_id;
+    *player_id = welcome.player_id;
+    if (welcome.reconnected) std::cout << "↩️  Back in your seat\n";
+    return fd;
+}
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [-m] [table] [name]\n"
+              << "       " << prog << " -s [-m] [name]\n"
+              << "       " << prog << " -w <table>\n"
+              << "  -s  join through the player socket; the server picks the seat\n"
+              << "      (the same name rejoins its seat in a running game)\n"
+              << "  -m  render from shared memory instead of STATE frames\n"
+              << "  -w  spectate a table\n";
+}
+
+int main(int argc, char* argv[]) {
+    bool shm_view = false;
+    bool use_socket = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "msw:")) != -1) {
+        switch (opt) {
+        case 'm': shm_view = true; break;
+        case 's': use_socket = true; break;
+        case 'w': return watch_table(atoi(optarg));   // spectate instead of playing
+        default: usage(argv[0]); return 1;
+        }
+    }
+
+    // Optional table ID (default: table 0, not with -s) and player name,
+    // under which wins are recorded (default: one name per table seat)
+    int arg = optind;
+    int table_id = (!use_socket && argc > arg) ? atoi(argv[arg++]) : 0;
+    const char* name = (argc > arg) ? argv[arg] : nullptr;
+    if (table_id < 0 || table_id >= MAX_TABLES) {
+        std::cerr << "Invalid table ID\n";
+        return 1;
+    }
+    if (name && (strlen(name) == 0 || strlen(name) >= MAX_NAME_LEN)) {
+        std::cerr << "Player name must be 1-" << MAX_NAME_LEN - 1 << " characters\n";
+        return 1;
+    }
+
+    int player_id;
+    int fd_in, fd_out;
+    if (use_socket) {
+        fd_in = fd_out = join_socket(name, &table_id, &player_id);
+        if (fd_in < 0) return 1;
+    }
+    else {
+        // Seats the server does not use (-p) have no FIFOs and fail to open below
+        std::cout << "Enter player ID (0-" << MAX_PLAYERS - 1 << " for up to " << MAX_PLAYERS
+                  << " players): ";
+        std::cin >> player_id;
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+        if (player_id < 0 || player_id >= MAX_PLAYERS) {
+            std::cerr << "Invalid player ID (must be 0-" << MAX_PLAYERS - 1 << ")\n";
+            return 1;
+        }
+
+        std::string in_fifo  = fifo_path(table_id, player_id, "out");
+        std::string out_fifo = fifo_path(table_id, player_id, "in");
+
+        fd_in  = open(in_fifo.c_str(), O_RDONLY);
+        fd_out = open(out_fifo.c_str(), O_WRONLY);
+
+        if (fd_in < 0 || fd_out < 0) {
+            perror("FIFO open");
+            return 1;
+        }
+
+        // Sent even without a name: it brings back a seat that went idle
+        send_msg(fd_out, MSG_HELLO, name, name ? strlen(name) : 0);
+    }
+
+    std::cout << "✅ Connected as Player " << player_id << " at table " << table_id << "\n";
+    std::cout << "Waiting for game to start...\n";
+
+    std::thread renderer;
+    if (shm_view) {
+        const Table* table = map_table(table_id);
+        if (!table) return 1;
+        send_msg(fd_out, MSG_SHM_VIEW);
+        renderer = std::thread(render_loop, table, player_id);
+    }
+
+    // Reusable receive buffer; messages are parsed in place
+    static MsgReader<MAX_PAYLOAD + sizeof(MsgHeader)> reader;
+    MsgView msg;
+
+    // ENTER is watched together with the server, so it also works while
+    // no prompt is pending. Every YOUR_TURN is owed one ROLL, even after
+    // its deadline passed (the server drops the late ones); an idle seat
+    // is brought back by the next one, or by a HELLO if none is owed.
+    int prompts = 0;
+    bool idle = false;
+    bool stdin_open = true;   // at EOF, prompts are answered at once
+
+    while (true) {
+        pollfd pfds[2] = {
+            { fd_in, POLLIN, 0 },
+            { STDIN_FILENO, POLLIN, 0 },
+        };
+        if (poll(pfds, stdin_open ? 2 : 1, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        if (pfds[1].revents) {
+            char keys[256];
+            ssize_t n = read(STDIN_FILENO, keys, sizeof(keys));
+            if (n <= 0) stdin_open = false;
+            for (ssize_t i = 0; i < n; i++) {
+                if (keys[i] != '\n') continue;
+                if (prompts > 0) {
+                    send_msg(fd_out, MSG_ROLL);
+                    prompts--;
+                } else if (idle) {
+                    send_msg(fd_out, MSG_HELLO, name, name ? strlen(name) : 0);
+                } else {
+                    continue;
+                }
+                if (idle) {
+                    std::lock_guard<std::mutex> lock(g_screen_mutex);
+                    std::cout << "↩️  Back in the game. Waiting for your turn...\n";
+                    idle = false;
+                }
+            }
+            if (!stdin_open) {
+                for (; prompts > 0; prompts--) send_msg(fd_out, MSG_ROLL);
+            }
+        }
+        if (!pfds[0].revents) continue;
+        if (reader.fill(fd_in) <= 0) break;
+
+        while (reader.next(msg)) {
+            if (msg.type == MSG_STATE && shm_view) {
+                continue;   // sent before the server saw MSG_SHM_VIEW
+            }
+            else if (msg.type == MSG_STATE && msg.length >= sizeof(StateDelta)) {
+                std::cout << "\033[2J\033[H";
+                std::cout.write(msg.payload + sizeof(StateDelta), msg.length - sizeof(StateDelta));
+                std::cout.flush();
+            }
+            else if (msg.type == MSG_YOUR_TURN) {
+                if (!stdin_open) {
+                    send_msg(fd_out, MSG_ROLL);
+                    continue;
+                }
+                prompts++;
+                if (!shm_view) {   // the renderer shows the prompt from the state
+                    std::cout << "\n🎲 Your turn! Press ENTER to roll dice...";
+                    std::cout.flush();
+                }
+            }
+            else if (msg.type == MSG_TIMEOUT && msg.length >= sizeof(TimeoutMsg)) {
+                TimeoutMsg timeout;
+                std::memcpy(&timeout, msg.payload, sizeof(timeout));
+                if (timeout.idle) idle = true;
+                std::lock_guard<std::mutex> lock(g_screen_mutex);
+                std::cout << "\n⏰ Too slow! " << (timeout.rolled ? "The server rolled for you."
+                                                                 : "Your turn was skipped.")
+                          << (timeout.idle ? " You are now idle: press ENTER to play again." : "")
+                          << "\n";
+            }
+            else if (msg.type == MSG_WIN) {
+                std::lock_guard<std::mutex> lock(g_screen_mutex);
+                std::cout << "\n🎉🎉🎉 YOU WIN! 🎉🎉🎉\n";
+                std::cout << "Waiting for next game...\n";
+            }
+            else if (msg.type == MSG_GAME_OVER && msg.length >= sizeof(GameOverMsg)) {
+                GameOverMsg over;
+                std::memcpy(&over, msg.payload, sizeof(over));
+                std::lock_guard<std::mutex> lock(g_screen_mutex);
+                if (over.winner != player_id)
+                    std::cout << "Game over. Player " << over.winner
+                              << " won. Waiting for next game...\n";
+            }
+        }
+
+        if (reader.error) {
+            std::cerr << "Protocol error from server\n";
+            break;
+        }
+    }
+
+    g_done = true;
+    if (renderer.joinable()) renderer.join();
+    close(fd_in);
+    if (fd_out != fd_in) close(fd_out);
+    return 0;
+}
+
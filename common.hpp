@@ -1,53 +1,293 @@
-#ifndef COMMON_HPP
-#define COMMON_HPP
-
-#include <pthread.h>
-#include <string>
-
-constexpr int MAX_PLAYERS = 5;     
-constexpr int MAX_NAME_LEN = 32;
-constexpr int WIN_POSITION = 40;
-
-// ---- Game State ----
-struct GameState {
-    int positions[MAX_PLAYERS];
-    int current_turn;
-    int active_players;
-    int num_players;        
-    int game_active;
-    int winner;
-    int game_over;          
-    int turn_complete;      
-};
-
-// ---- Player Info ----
-struct Player {
-    int connected;
-    char name[MAX_NAME_LEN];
-};
-
-// ---- Shared Memory ----
-struct SharedData {
-    GameState game;
-    Player players[MAX_PLAYERS];
-    
-    // Mutexes
-    pthread_mutex_t game_mutex;
-    pthread_mutex_t log_mutex;
-    pthread_mutex_t score_mutex;
-    
-    // Logger
-    char log_buffer[256];
-    int log_pending;        
-    
-    // Scores
-    int scores[MAX_PLAYERS];
-};
-
-
-// ---- Logger ----
-char log_buffer[256];
-int log_pending;   // 0 = none, 1 = has log
-
-#endif
-
+#ifndef COMMON_HPP
+#define COMMON_HPP
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <string>
+#include <time.h>
+
+#include "dice_rng.hpp"
+#include "event_log.hpp"
+#include "log_ring.hpp"
+#include "mpsc_queue.hpp"
+#include "seat_mask.hpp"
+#include "seqlock.hpp"
+
+// Seats per table, fixed at build time because every table in shared
+// memory is sized for it; -p picks how many a server uses (up to this)
+#ifndef TABLE_SEATS
+#define TABLE_SEATS 5              // set at build time: make SEATS=64
+#endif
+constexpr int MAX_PLAYERS = TABLE_SEATS;
+static_assert(MAX_PLAYERS >= 3 && MAX_PLAYERS <= 1024, "tables seat 3 to 1024 players");
+constexpr int MAX_NAME_LEN = 32;
+#ifndef RACE_GOAL
+#define RACE_GOAL 40               // set at build time: make GOAL=60
+#endif
+constexpr int WIN_POSITION = RACE_GOAL;
+constexpr int MAX_TABLES = 65536;  // virtual reservation, must be a power of two
+constexpr int TABLE_CHUNK = 256;   // tables added per segment growth
+constexpr int SCORE_QUEUE_SIZE = 4096;   // wins awaiting the scorekeeper
+constexpr size_t CACHE_LINE = 64;
+
+constexpr const char* SHM_NAME = "/race_game_shm";
+constexpr const char* TABLES_SHM_NAME = "/race_game_tables";
+constexpr uint32_t SHM_MAGIC = 0x52534D31;   // "RSM1"
+constexpr uint32_t SHM_VERSION = 6;          // bump when SharedData, Table or their parts change
+
+// ---- Game State ----
+// The latest roll at a table, what a STATE frame reports. Kept across
+// game resets, so a frame rendered late still names the winner.
+struct LastRoll {
+    uint32_t seq;           // rolls committed at the table so far
+    int player_id;
+    int dice;
+    int position;
+    int winner;             // player_id if the roll won, else -1
+};
+
+struct GameState {
+    int positions[MAX_PLAYERS];
+    int current_turn;
+    int active_players;
+    int num_players;        
+    int game_active;
+    int winner;
+    int game_over;          
+    int turn_complete;      
+    LastRoll last_roll;
+};
+
+// ---- Leaderboard order ----
+// Seats ranked by position, best first, ties in seat order. Updated under
+// game_mutex by ranking_update() after every roll: only the seat that
+// moved can be out of place, so it is shifted to its new rank instead of
+// the whole table being sorted again.
+struct Ranking {
+    uint16_t order[MAX_PLAYERS];   // seat at each rank
+    uint16_t rank[MAX_PLAYERS];    // rank of each seat
+};
+
+// Everyone at the start line: seat order
+inline void ranking_reset(Ranking* r, int num_players) {
+    for (int i = 0; i < num_players; i++) r->order[i] = r->rank[i] = i;
+}
+
+inline bool ranking_ahead(const int positions[], int a, int b) {
+    return positions[a] > positions[b] || (positions[a] == positions[b] && a < b);
+}
+
+// `seat`'s position changed; move it up or down to where it now ranks
+inline void ranking_update(Ranking* r, const int positions[], int num_players, int seat) {
+    int i = r->rank[seat];
+    while (i > 0 && ranking_ahead(positions, seat, r->order[i - 1])) {
+        r->order[i] = r->order[i - 1];
+        r->rank[r->order[i]] = i;
+        i--;
+    }
+    while (i < num_players - 1 && ranking_ahead(positions, r->order[i + 1], seat)) {
+        r->order[i] = r->order[i + 1];
+        r->rank[r->order[i]] = i;
+        i++;
+    }
+    r->order[i] = seat;
+    r->rank[seat] = i;
+}
+
+// From scratch, for state that was not kept up to date (crash repair)
+inline void ranking_rebuild(Ranking* r, const int positions[], int num_players) {
+    for (int i = 0; i < num_players; i++) {
+        int j = i;
+        for (; j > 0 && ranking_ahead(positions, i, r->order[j - 1]); j--)
+            r->order[j] = r->order[j - 1];
+        r->order[j] = i;
+    }
+    for (int i = 0; i < num_players; i++) r->rank[r->order[i]] = i;
+}
+
+// ---- Player Info ----
+struct Player {
+    int connected;
+    char name[MAX_NAME_LEN];
+    int shm_view;           // renders from shared memory, gets no STATE frames
+    uint32_t session;       // socket tables: bumped each time a connection takes the seat
+    int handler_pid;        // fork mode: process serving the seat, stopped by a warm restart
+    int missed_turns;       // turn deadlines missed in a row
+    int idle;               // disconnected for missing them, any input brings the player back
+};
+
+// ---- Broadcast counters (updated with atomic adds by any process) ----
+struct BroadcastStats {
+    long long broadcasts;   // frames fanned out
+    long long syscalls;     // write syscalls spent on them
+    long long bytes;        // bytes accepted by the FIFOs
+    long long drops;        // recipients that were behind (frame queued)
+    long long wakes;        // futex wakes for shared-memory viewers
+};
+
+// Room for one STATE frame of a full table: the message and delta
+// headers, the track's title and three lines plus a blank one per racer
+// (protocol.hpp checks that the longest track fits)
+constexpr size_t STATE_FRAME_MAX = 256 + MAX_PLAYERS * (3 * (11 + WIN_POSITION + 10) + 1);
+
+// ---- Table (one independent game shard) ----
+// Laid out in cache-line regions by who writes them. Tables are line
+// aligned and a whole number of lines long, so neighbouring tables in the
+// segment never share a line either.
+struct alignas(CACHE_LINE) Table {
+    // -- Turn path: lock, wakeups and the state they guard --
+    // Per-table lock: tables never share a mutex on the turn path
+    pthread_mutex_t game_mutex;
+    std::atomic<uint32_t> turn_seq;    // bumped when the turn may have moved or a game
+                                       // was won, see turn_wake()
+    GameState game;
+    SeatMask<MAX_PLAYERS> seats_connected;   // players[].connected, see set_seat_connected()
+    Ranking ranking;                   // leaderboard order of game.positions
+    std::atomic<uint32_t> state_seq;   // seqlock over game, see table_snapshot()
+    int state_watchers;                // shm_view seats, woken on every state change
+
+    // Turn handoff latency (commit of one roll -> next YOUR_TURN), under game_mutex
+    long long turn_committed_ns;
+    long long handoff_total_ns;
+    long long handoff_max_ns;
+    int handoff_count;
+
+    // -- Read-mostly: written on connect, name change and game start --
+    alignas(CACHE_LINE) int id;
+    int dynamic;            // seats handed out by the player listener (socket table)
+    Player players[MAX_PLAYERS];
+    uint64_t game_number;
+    uint64_t game_seed;
+
+    // -- Per seat: dice reseeded at every game start from the master seed.
+    // Each seat only draws from its own (line-aligned) stream, on its turn.
+    DiceRng dice[MAX_PLAYERS];
+
+    // -- Fork mode: the latest roll's STATE frame, rendered once by the
+    // handler that committed it and copied out by every seat's handler
+    // (see publish_state_frame() in server.cpp) --
+    alignas(CACHE_LINE) std::atomic<uint32_t> frame_seq;   // seqlock over the frame
+    uint32_t frame_roll;               // game.last_roll.seq the frame shows
+    uint32_t frame_length;             // bytes of the frame, header included
+    char frame[STATE_FRAME_MAX];
+
+    // -- Atomic adds from every seat, kept off the lock's lines --
+    alignas(CACHE_LINE) BroadcastStats broadcast;
+};
+
+static_assert(sizeof(Table) % CACHE_LINE == 0, "tables must not share cache lines");
+
+// A seat joins or leaves the turn order. Caller holds game_mutex.
+inline void set_seat_connected(Table* table, int seat, bool connected) {
+    table->players[seat].connected = connected ? 1 : 0;
+    table->seats_connected.set(seat, connected);
+}
+
+// ---- Game state snapshots ----
+// Every change to table->game happens under game_mutex inside
+// state_write_begin/end. Readers that only need a consistent copy
+// (rendering, leaderboards, observers) call table_snapshot() and never
+// touch game_mutex, so they cannot delay the player who is rolling.
+inline void state_write_begin(Table* table) {
+    seq_write_begin(&table->state_seq);
+}
+
+inline void state_write_end(Table* table) {
+    seq_write_end(&table->state_seq);
+    if (table->state_watchers > 0) {
+        seq_wake(&table->state_seq);
+        __atomic_add_fetch(&table->broadcast.wakes, 1, __ATOMIC_RELAXED);
+    }
+}
+
+// Returns the snapshot's version; it changes whenever the state does
+inline uint32_t table_snapshot(const Table* table, GameState* out) {
+    return seq_read(&table->state_seq, out, &table->game);
+}
+
+// Sleep until the table's state moves past `version` (shared-memory viewers)
+inline void table_wait(const Table* table, uint32_t version, int timeout_ms) {
+    seq_wait(&table->state_seq, version, timeout_ms);
+}
+
+// ---- Turn wakeups ----
+// Forked handlers sleep on turn_seq instead of a condition variable. A
+// futex word holds no internal lock, so a handler killed while waiting
+// cannot wedge its table the way a dead waiter can wedge a shared
+// pthread_cond_t. Callers hold game_mutex.
+inline void turn_wake(Table* table) {
+    table->turn_seq.fetch_add(1, std::memory_order_release);
+    seq_wake(&table->turn_seq);
+}
+
+// ---- Win event (handler -> scorekeeper) ----
+struct ScoreEvent {
+    char name[MAX_NAME_LEN];
+    int table_id;
+};
+
+// ---- Shared Memory ----
+// Control block. Tables live in a separate segment (TABLES_SHM_NAME) that
+// is reserved for MAX_TABLES up front and grown TABLE_CHUNK tables at a time.
+// Both outlive a server stopped for a warm restart (SIGTERM); the next
+// server (-R) checks the header before it reattaches.
+struct SharedData {
+    // -- Segment header: written once the segment is fully initialized --
+    uint32_t magic;                 // SHM_MAGIC
+    uint32_t version;               // SHM_VERSION of the server that created it
+    uint32_t shared_size;           // sizeof(SharedData) and sizeof(Table) there
+    uint32_t table_size;
+    int server_pid;                 // server attached now, 0 once it stopped
+    int num_players;                // players per FIFO table
+    int fifo_tables;                // tables 0..fifo_tables-1 are played over FIFOs
+    int restarts;                   // warm restarts so far
+
+    // -- Read-mostly configuration --
+    long long game_pause_ns;        // pause between a win and the next game
+    long long turn_deadline_ns;     // time to roll once prompted, 0 = no deadline
+    int deadline_roll;              // on expiry roll for the player (1) or skip the turn (0)
+    int idle_after;                 // missed deadlines in a row before the seat goes idle
+    uint64_t dice_seed;             // master seed, logged for replays
+
+    // -- Table manager: only taken to allocate tables --
+    alignas(CACHE_LINE) pthread_mutex_t table_mutex;
+    int num_tables;                 // tables handed out
+    int table_capacity;             // tables backed by the segment
+
+    // -- Locks taken by different processes for unrelated work --
+    alignas(CACHE_LINE) pthread_mutex_t log_mutex;
+    alignas(CACHE_LINE) pthread_mutex_t score_mutex;
+
+    // Scheduler: handlers enqueue the table id when they commit a roll.
+    // A table has at most one roll in flight, so the queue never overflows.
+    alignas(CACHE_LINE) sem_t sched_sem;
+    MpscQueue<int, MAX_TABLES> sched_queue;
+
+    // Scorekeeper: wins are journaled in batches by scorekeeper_thread.
+    // score_mutex guards the parent's score store (thread vs. shutdown).
+    alignas(CACHE_LINE) sem_t score_sem;
+    MpscQueue<ScoreEvent, SCORE_QUEUE_SIZE> score_queue;
+
+    // Event log: records numbered and written to events-*.bin by
+    // logger_thread, which producers wake through log_ring.wakeup
+    alignas(CACHE_LINE) MpscQueue<EventRecord, EVENT_QUEUE_SIZE> event_queue;
+
+    // Logger (lock-free MPSC ring drained by logger_thread)
+    LogRing log_ring;
+};
+
+// ---- FIFO naming ----
+inline std::string fifo_path(int table_id, int player_id, const char* dir) {
+    return "/tmp/race_" + std::to_string(table_id) + "_player_" +
+           std::to_string(player_id) + "_" + dir;
+}
+
+// ---- Time ----
+inline long long monotonic_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+#endif
+
@@ -0,0 +1,85 @@
+#ifndef DICE_RNG_HPP
+#define DICE_RNG_HPP
+
+#include <cstdint>
+
+// ---- Dice RNG ----
+// xoshiro256** streams derived from one master seed, so any game can be
+// replayed exactly:
+//
+//   game seed = mix(master seed, table id, game number)
+//   seat      = own stream seeded from mix(game seed, seat)
+//
+// Every seat draws only from its own stream, so a seat's rolls in a game
+// do not depend on what other seats rolled or when they rolled. Rolls are
+// pre-generated DICE_BATCH at a time; the state is plain data and can
+// live in shared memory.
+constexpr int DICE_BATCH = 64;
+
+// splitmix64: seeds xoshiro and mixes ids into seeds
+inline uint64_t splitmix64(uint64_t& x) {
+    uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+inline uint64_t dice_mix(uint64_t seed, uint64_t value) {
+    uint64_t x = seed ^ (value * 0xD1B54A32D192ED03ULL);
+    return splitmix64(x);
+}
+
+inline uint64_t dice_game_seed(uint64_t master, int table_id, uint64_t game) {
+    return dice_mix(dice_mix(master, table_id), game);
+}
+
+// One cache line pair per stream, so seats drawing from neighbouring
+// streams in shared memory never write the same line
+struct alignas(64) DiceRng {
+    uint64_t s[4];
+    uint8_t batch[DICE_BATCH];
+    int next;                    // == DICE_BATCH when the batch is used up
+};
+
+inline uint64_t rotl64(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+inline uint64_t xoshiro_next(uint64_t s[4]) {
+    uint64_t result = rotl64(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl64(s[3], 45);
+    return result;
+}
+
+inline void dice_seed(DiceRng* rng, uint64_t game_seed, int seat) {
+    uint64_t x = dice_mix(game_seed, seat + 1);
+    for (int i = 0; i < 4; i++) rng->s[i] = splitmix64(x);
+    rng->next = DICE_BATCH;
+}
+
+// Refill the batch. Each random byte below 252 (= 6 * 42) is one unbiased
+// die; the rest are rejected.
+inline void dice_refill(DiceRng* rng) {
+    int filled = 0;
+    while (filled < DICE_BATCH) {
+        uint64_t bits = xoshiro_next(rng->s);
+        for (int b = 0; b < 8 && filled < DICE_BATCH; b++, bits >>= 8) {
+            uint8_t byte = bits & 0xFF;
+            if (byte < 252) rng->batch[filled++] = byte % 6 + 1;
+        }
+    }
+    rng->next = 0;
+}
+
+inline int dice_roll(DiceRng* rng) {
+    if (rng->next == DICE_BATCH) dice_refill(rng);
+    return rng->batch[rng->next++];
+}
+
+#endif
@@ -0,0 +1,224 @@
+#ifndef EVENT_LOG_HPP
+#define EVENT_LOG_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// ---- Binary event log ----
+// game.log stays the human-readable log. Next to it, every game event is
+// appended as a fixed 32-byte record to numbered segment files:
+//
+//   events-000000.bin   header, then records with seq 0, 1, 2, ...
+//   events-000001.bin   opened once the previous one holds
+//                       EVENT_SEGMENT_RECORDS records
+//
+// Producers (handlers, reactors, the listener) push records into a
+// lock-free queue in shared memory; the logger thread gives them their
+// sequence numbers and writes them out in batches. Sequence numbers carry
+// on across segments and server restarts, so a gap means lost records.
+// The events tool maps the segments and scans them (see events.cpp).
+constexpr uint32_t EVENT_MAGIC = 0x31564552;   // "REV1"
+constexpr uint16_t EVENT_VERSION = 1;
+constexpr unsigned EVENT_QUEUE_SIZE = 8192;    // records awaiting the logger
+constexpr const char* EVENT_SEGMENT_PREFIX = "events-";
+constexpr const char* EVENT_SEGMENT_SUFFIX = ".bin";
+#ifndef EVENT_SEGMENT_RECORDS
+#define EVENT_SEGMENT_RECORDS (1 << 21)        // 64 MiB segments
+#endif
+
+enum EventType : uint8_t {
+    EV_GAME_START = 1,   // value = players at the table
+    EV_ROLL       = 2,   // seat rolled arg, value = new position
+    EV_WIN        = 3,   // seat won, value = its position
+    EV_DEADLINE   = 4,   // seat missed the turn deadline, arg = 1 if rolled for
+    EV_IDLE       = 5,   // seat went idle after missing deadlines
+    EV_RETURN     = 6,   // idle seat back after input
+    EV_JOIN       = 7,   // socket player seated, arg = 1 for a rejoin
+    EV_LEAVE      = 8,   // socket player left
+};
+
+struct EventRecord {
+    uint64_t seq;        // assigned by the logger
+    int64_t time_ns;     // CLOCK_REALTIME when the event happened
+    uint32_t table;
+    uint32_t game;       // table's game number (low 32 bits)
+    uint8_t type;        // EventType
+    uint8_t arg;
+    uint16_t seat;
+    int32_t value;
+};
+static_assert(sizeof(EventRecord) == 32, "event records are 32 bytes on disk");
+
+// First 64 bytes of every segment
+struct EventSegmentHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t segment;    // number in the file name
+    uint32_t reserved;
+    uint64_t first_seq;  // seq of the segment's first record
+    int64_t created_ns;
+    uint8_t pad[32];
+};
+static_assert(sizeof(EventSegmentHeader) == 64, "segment header is 64 bytes on disk");
+
+inline const char* event_type_name(uint8_t type) {
+    switch (type) {
+    case EV_GAME_START: return "GAME_START";
+    case EV_ROLL:       return "ROLL";
+    case EV_WIN:        return "WIN";
+    case EV_DEADLINE:   return "DEADLINE";
+    case EV_IDLE:       return "IDLE";
+    case EV_RETURN:     return "RETURN";
+    case EV_JOIN:       return "JOIN";
+    case EV_LEAVE:      return "LEAVE";
+    default:            return "UNKNOWN";
+    }
+}
+
+inline long long realtime_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+inline std::string event_segment_path(const std::string& dir, uint32_t segment) {
+    char name[64];
+    snprintf(name, sizeof(name), "%s%06u%s", EVENT_SEGMENT_PREFIX, segment, EVENT_SEGMENT_SUFFIX);
+    return dir + "/" + name;
+}
+
+// Segment numbers present in `dir`, ascending
+inline std::vector<uint32_t> event_segments(const std::string& dir) {
+    std::vector<uint32_t> segments;
+    DIR* d = opendir(dir.c_str());
+    if (!d) return segments;
+
+    size_t prefix = strlen(EVENT_SEGMENT_PREFIX);
+    while (dirent* entry = readdir(d)) {
+        unsigned number;
+        char suffix[8];
+        if (strncmp(entry->d_name, EVENT_SEGMENT_PREFIX, prefix) == 0 &&
+            sscanf(entry->d_name + prefix, "%u%7s", &number, suffix) == 2 &&
+            strcmp(suffix, EVENT_SEGMENT_SUFFIX) == 0)
+            segments.push_back(number);
+    }
+    closedir(d);
+
+    for (size_t i = 1; i < segments.size(); i++)   // few segments: insertion sort
+        for (size_t j = i; j > 0 && segments[j - 1] > segments[j]; j--)
+            std::swap(segments[j - 1], segments[j]);
+    return segments;
+}
+
+// ---- Writer (logger thread only) ----
+struct EventLog {
+    std::string dir;
+    int fd = -1;
+    uint32_t segment = 0;
+    uint64_t records = 0;     // in the open segment
+    uint64_t next_seq = 0;
+};
+
+inline bool event_log_create_segment(EventLog* log, uint32_t segment) {
+    std::string path = event_segment_path(log->dir, segment);
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (fd < 0) {
+        perror(path.c_str());
+        return false;
+    }
+
+    EventSegmentHeader header{};
+    header.magic = EVENT_MAGIC;
+    header.version = EVENT_VERSION;
+    header.record_size = sizeof(EventRecord);
+    header.segment = segment;
+    header.first_seq = log->next_seq;
+    header.created_ns = realtime_ns();
+    if (write(fd, &header, sizeof(header)) != static_cast<ssize_t>(sizeof(header))) {
+        perror(path.c_str());
+        close(fd);
+        return false;
+    }
+
+    if (log->fd >= 0) close(log->fd);
+    log->fd = fd;
+    log->segment = segment;
+    log->records = 0;
+    return true;
+}
+
+// Continue the newest segment in `dir` (or start segment 0). A record cut
+// short by a crash is dropped; numbering resumes after the last whole one.
+inline bool event_log_open(EventLog* log, const std::string& dir) {
+    log->dir = dir;
+    std::vector<uint32_t> segments = event_segments(dir);
+    if (segments.empty()) return event_log_create_segment(log, 0);
+
+    uint32_t last = segments.back();
+    std::string path = event_segment_path(dir, last);
+    int fd = open(path.c_str(), O_RDWR | O_APPEND);
+    EventSegmentHeader header{};
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0 ||
+        pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+        header.magic != EVENT_MAGIC || header.record_size != sizeof(EventRecord)) {
+        // Unreadable: leave it for inspection and start the next segment
+        std::cerr << "[LOGGER] " << path << " is not an event segment, starting a new one\n";
+        if (fd >= 0) close(fd);
+        return event_log_create_segment(log, last + 1);
+    }
+
+    uint64_t records = (st.st_size - sizeof(header)) / sizeof(EventRecord);
+    off_t whole = sizeof(header) + records * sizeof(EventRecord);
+    if (whole != st.st_size && ftruncate(fd, whole) < 0) perror(path.c_str());
+
+    log->fd = fd;
+    log->segment = last;
+    log->records = records;
+    log->next_seq = header.first_seq + records;
+    if (records >= EVENT_SEGMENT_RECORDS) return event_log_create_segment(log, last + 1);
+    return true;
+}
+
+// Number and write a batch, rotating to a new segment when one fills up.
+// Returns the number of records written.
+inline int event_log_append(EventLog* log, EventRecord* records, int count) {
+    int written = 0;
+    while (written < count && log->fd >= 0) {
+        if (log->records >= EVENT_SEGMENT_RECORDS &&
+            !event_log_create_segment(log, log->segment + 1))
+            break;
+
+        int n = static_cast<int>(std::min<uint64_t>(count - written,
+                                                    EVENT_SEGMENT_RECORDS - log->records));
+        for (int i = 0; i < n; i++) records[written + i].seq = log->next_seq + i;
+
+        ssize_t bytes = n * sizeof(EventRecord);
+        if (write(log->fd, records + written, bytes) != bytes) {
+            perror("write event segment");
+            break;
+        }
+        log->next_seq += n;
+        log->records += n;
+        written += n;
+    }
+    return written;
+}
+
+inline void event_log_close(EventLog* log) {
+    if (log->fd >= 0) close(log->fd);
+    log->fd = -1;
+}
+
+#endif
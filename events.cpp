@@ -0,0 +1,299 @@
+#include <iostream>
+#include <iomanip>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "event_log.hpp"
+#include "histogram.hpp"
+
+// Queries over the server's binary event log (events-*.bin, see
+// event_log.hpp). Segments are memory-mapped and scanned once, front to
+// back, with per-table and per-seat state in flat arrays: no parsing and
+// no allocation per record, so a scan runs at about memory bandwidth.
+//
+//   ./events             summary: per-seat rolls and wins, game lengths,
+//                        turn timings, sequence gaps
+//   ./events -t 3        the same for table 3 only
+//   ./events -x          every record as a line of text
+
+struct Segment {
+    uint32_t number;
+    const EventRecord* records;
+    uint64_t count;
+    void* mapped;
+    size_t size;
+};
+
+struct SeatStats {
+    uint64_t rolls;
+    uint64_t pips;              // sum of the dice rolled
+    uint64_t wins;
+    uint64_t deadlines;
+};
+
+// Game in progress at a table
+struct TableState {
+    bool open;
+    uint32_t game;
+    int64_t start_ns;
+    int64_t last_roll_ns;
+    uint64_t rolls;
+};
+
+struct Summary {
+    uint64_t seen;              // all records, for the sequence check
+    uint64_t records;           // records that passed the filter
+    uint64_t first_seq, last_seq;
+    uint64_t gaps, missing;     // holes in the sequence numbers
+    int64_t first_ns, last_ns;
+    uint64_t by_type[256];
+
+    std::vector<SeatStats> seats;
+    std::vector<TableState> tables;
+
+    uint64_t games;             // started and won within the log
+    LatencyHistogram game_turns;
+    LatencyHistogram game_ns;
+    LatencyHistogram turn_ns;   // game start or previous roll -> roll
+};
+
+// Map every segment in `dir`; an unreadable or foreign file is skipped
+std::vector<Segment> map_segments(const std::string& dir) {
+    std::vector<Segment> segments;
+    for (uint32_t number : event_segments(dir)) {
+        std::string path = event_segment_path(dir, number);
+        int fd = open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) < 0) {
+            perror(path.c_str());
+            if (fd >= 0) close(fd);
+            continue;
+        }
+        if (st.st_size < static_cast<off_t>(sizeof(EventSegmentHeader))) {
+            close(fd);
+            continue;
+        }
+
+        void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            perror(path.c_str());
+            continue;
+        }
+
+        const EventSegmentHeader* header = static_cast<const EventSegmentHeader*>(mapped);
+        if (header->magic != EVENT_MAGIC || header->record_size != sizeof(EventRecord)) {
+            std::cerr << path << ": not an event segment, skipped\n";
+            munmap(mapped, st.st_size);
+            continue;
+        }
+        madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+
+        Segment segment;
+        segment.number = number;
+        segment.records = reinterpret_cast<const EventRecord*>(header + 1);
+        segment.count = (st.st_size - sizeof(EventSegmentHeader)) / sizeof(EventRecord);
+        segment.mapped = mapped;
+        segment.size = st.st_size;
+        segments.push_back(segment);
+    }
+    return segments;
+}
+
+// Sequence numbers are checked across all tables; everything else only
+// counts records of `table_filter` (-1: every table)
+void scan(const EventRecord& r, long table_filter, Summary* s) {
+    if (s->seen == 0) {
+        s->first_seq = r.seq;
+        s->first_ns = r.time_ns;
+    } else if (r.seq != s->last_seq + 1) {
+        s->gaps++;
+        if (r.seq > s->last_seq) s->missing += r.seq - s->last_seq - 1;
+    }
+    s->seen++;
+    s->last_seq = r.seq;
+    s->last_ns = r.time_ns;
+    if (table_filter >= 0 && r.table != table_filter) return;
+    s->records++;
+    s->by_type[r.type]++;
+
+    if (r.seat >= s->seats.size()) s->seats.resize(r.seat + 1);
+    if (r.table >= s->tables.size()) s->tables.resize(r.table + 1);
+    SeatStats& seat = s->seats[r.seat];
+    TableState& table = s->tables[r.table];
+    bool in_game = table.open && table.game == r.game;
+
+    switch (r.type) {
+    case EV_GAME_START:
+        table.open = true;
+        table.game = r.game;
+        table.start_ns = table.last_roll_ns = r.time_ns;
+        table.rolls = 0;
+        break;
+    case EV_ROLL:
+        seat.rolls++;
+        seat.pips += r.arg;
+        if (in_game) {
+            hist_record(&s->turn_ns, r.time_ns - table.last_roll_ns);
+            table.last_roll_ns = r.time_ns;
+            table.rolls++;
+        }
+        break;
+    case EV_WIN:
+        seat.wins++;
+        if (in_game) {
+            s->games++;
+            hist_record(&s->game_turns, table.rolls);
+            hist_record(&s->game_ns, r.time_ns - table.start_ns);
+            table.open = false;
+        }
+        break;
+    case EV_DEADLINE:
+        seat.deadlines++;
+        break;
+    default:
+        break;
+    }
+}
+
+std::string format_time(int64_t ns) {
+    time_t seconds = ns / 1000000000;
+    tm local;
+    localtime_r(&seconds, &local);
+    char text[64];
+    size_t len = strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &local);
+    snprintf(text + len, sizeof(text) - len, ".%03lld",
+             static_cast<long long>(ns / 1000000 % 1000));
+    return text;
+}
+
+void print_hist_ms(const char* name, const LatencyHistogram* h) {
+    std::cout << "   " << std::left << std::setw(14) << name << std::right
+              << " p50 " << hist_percentile(h, 50.0) / 1e6
+              << " ms, p99 " << hist_percentile(h, 99.0) / 1e6
+              << " ms, p99.9 " << hist_percentile(h, 99.9) / 1e6 << " ms\n";
+}
+
+void print_summary(const std::vector<Segment>& segments, const Summary& s, double scan_s,
+                   uint64_t bytes) {
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "=== Event log ===\n";
+    std::cout << " Segments: " << segments.size() << " (" << bytes / (1024.0 * 1024.0)
+              << " MiB), scanned in " << scan_s * 1000 << " ms ("
+              << bytes / scan_s / 1e9 << " GB/s)\n";
+    if (s.seen == 0) {
+        std::cout << " No records\n";
+        return;
+    }
+
+    std::cout << " Records: " << s.seen << ", seq " << s.first_seq << " .. " << s.last_seq
+              << ", " << s.gaps << " gap(s) (" << s.missing << " missing)\n";
+    if (s.records != s.seen) std::cout << " Selected: " << s.records << " records\n";
+    std::cout << " Time: " << format_time(s.first_ns) << " .. " << format_time(s.last_ns)
+              << " (" << (s.last_ns - s.first_ns) / 1e9 << " s)\n";
+    std::cout << " Events:";
+    for (int type = 0; type < 256; type++)
+        if (s.by_type[type]) std::cout << " " << event_type_name(type) << "=" << s.by_type[type];
+    std::cout << "\n";
+
+    std::cout << " Games: " << s.games << " played start to finish\n";
+    if (s.games) {
+        std::cout << "   turns          p50 " << hist_percentile(&s.game_turns, 50.0)
+                  << ", p99 " << hist_percentile(&s.game_turns, 99.0)
+                  << ", max " << hist_percentile(&s.game_turns, 100.0) << "\n";
+        print_hist_ms("duration", &s.game_ns);
+    }
+    if (hist_count(&s.turn_ns)) {
+        std::cout << " Turn timing (" << hist_count(&s.turn_ns) << " rolls):\n";
+        print_hist_ms("roll to roll", &s.turn_ns);
+    }
+
+    uint64_t total_wins = 0;
+    for (const SeatStats& seat : s.seats) total_wins += seat.wins;
+    std::cout << " Seat      rolls  mean roll    wins  win share  deadlines\n";
+    for (size_t i = 0; i < s.seats.size(); i++) {
+        const SeatStats& seat = s.seats[i];
+        if (!seat.rolls && !seat.wins && !seat.deadlines) continue;
+        std::cout << " " << std::setw(4) << i << std::setw(11) << seat.rolls
+                  << std::setprecision(2) << std::setw(11)
+                  << (seat.rolls ? static_cast<double>(seat.pips) / seat.rolls : 0.0)
+                  << std::setw(8) << seat.wins << std::setprecision(1) << std::setw(10)
+                  << (total_wins ? 100.0 * seat.wins / total_wins : 0.0) << "%"
+                  << std::setw(11) << seat.deadlines << "\n";
+    }
+}
+
+// One line per record, for humans and grep
+void export_text(const std::vector<Segment>& segments, long table_filter) {
+    for (const Segment& segment : segments) {
+        for (uint64_t i = 0; i < segment.count; i++) {
+            const EventRecord& r = segment.records[i];
+            if (table_filter >= 0 && r.table != table_filter) continue;
+            printf("%llu %s table=%u game=%u %s seat=%u arg=%u value=%d\n",
+                   static_cast<unsigned long long>(r.seq), format_time(r.time_ns).c_str(),
+                   r.table, r.game, event_type_name(r.type), r.seat, r.arg, r.value);
+        }
+    }
+}
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [-d dir] [-t table] [-x]\n"
+              << "  -d  directory holding events-*.bin (default: .)\n"
+              << "  -t  only records of this table\n"
+              << "  -x  print every record as text instead of the summary\n";
+}
+
+/* ========================================
+   MAIN
+   ======================================== */
+int main(int argc, char* argv[]) {
+    std::string dir = ".";
+    long table_filter = -1;
+    bool text = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "d:t:x")) != -1) {
+        switch (opt) {
+        case 'd': dir = optarg; break;
+        case 't': table_filter = atol(optarg); break;
+        case 'x': text = true; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+
+    std::vector<Segment> segments = map_segments(dir);
+    if (segments.empty()) {
+        std::cerr << "No event segments in " << dir << "\n";
+        return 1;
+    }
+
+    if (text) {
+        export_text(segments, table_filter);
+    } else {
+        Summary* summary = new Summary{};
+        uint64_t bytes = 0;
+        timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (const Segment& segment : segments) {
+            bytes += segment.count * sizeof(EventRecord);
+            for (uint64_t i = 0; i < segment.count; i++) {
+                scan(segment.records[i], table_filter, summary);
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double scan_s = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        print_summary(segments, *summary, scan_s > 0 ? scan_s : 1e-9, bytes);
+        delete summary;
+    }
+
+    for (const Segment& segment : segments) munmap(segment.mapped, segment.size);
+    return 0;
+}
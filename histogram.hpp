@@ -0,0 +1,67 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#include <cstdint>
+
+// ---- Latency Histogram ----
+// Log-linear buckets over nanoseconds: values below 16 get their own
+// bucket, above that each power of two is split into 16 sub-buckets
+// (<= 6.25% relative error). Plain counters, so it can live in shared
+// memory and be updated with atomic adds.
+constexpr int HIST_SUB_BITS = 4;
+constexpr int HIST_SUB = 1 << HIST_SUB_BITS;
+constexpr int HIST_MAX_EXP = 47;                  // ~39 hours in ns
+constexpr int HIST_BUCKETS = (HIST_MAX_EXP - HIST_SUB_BITS + 2) * HIST_SUB;
+
+struct LatencyHistogram {
+    uint64_t counts[HIST_BUCKETS];
+};
+
+inline int hist_bucket(uint64_t ns) {
+    if (ns < HIST_SUB) return static_cast<int>(ns);
+    int exp = 63 - __builtin_clzll(ns);
+    if (exp > HIST_MAX_EXP) return HIST_BUCKETS - 1;
+    int sub = static_cast<int>(ns >> (exp - HIST_SUB_BITS)) & (HIST_SUB - 1);
+    return (exp - HIST_SUB_BITS + 1) * HIST_SUB + sub;
+}
+
+// Lowest value that falls into the bucket
+inline uint64_t hist_bucket_value(int bucket) {
+    if (bucket < HIST_SUB) return bucket;
+    int exp = bucket / HIST_SUB + HIST_SUB_BITS - 1;
+    uint64_t sub = bucket % HIST_SUB;
+    return (1ULL << exp) | (sub << (exp - HIST_SUB_BITS));
+}
+
+inline void hist_record(LatencyHistogram* h, uint64_t ns) {
+    h->counts[hist_bucket(ns)]++;
+}
+
+// Safe to call from several processes at once
+inline void hist_record_atomic(LatencyHistogram* h, uint64_t ns) {
+    __atomic_add_fetch(&h->counts[hist_bucket(ns)], 1, __ATOMIC_RELAXED);
+}
+
+inline uint64_t hist_count(const LatencyHistogram* h) {
+    uint64_t total = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) total += h->counts[i];
+    return total;
+}
+
+// Value at percentile p (0-100); 0 if the histogram is empty
+inline uint64_t hist_percentile(const LatencyHistogram* h, double p) {
+    uint64_t total = hist_count(h);
+    if (total == 0) return 0;
+
+    uint64_t rank = static_cast<uint64_t>(p / 100.0 * total);
+    if (rank >= total) rank = total - 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen > rank) return hist_bucket_value(i);
+    }
+    return hist_bucket_value(HIST_BUCKETS - 1);
+}
+
+#endif
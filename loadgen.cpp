@@ -0,0 +1,538 @@
+#include <iostream>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <iomanip>
+#include <memory>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common.hpp"
+#include "histogram.hpp"
+#include "protocol.hpp"
+
+// Headless players: every bot is one FIFO pair driven from a single epoll
+// loop, rolling on each YOUR_TURN after the configured think time.
+// Optional spectators attach to the same tables in phases (-w 0,100,500)
+// to measure what viewers cost the players' turn latency.
+// With -j bots join through the player socket instead and are seated by
+// the server; -C then hangs up and rejoins bots to measure churn.
+
+/* ========================================
+   BOT STATE
+   ======================================== */
+// Receive buffers hold at least one whole frame of a full table
+constexpr size_t BOT_READ_BUFFER = STATE_PAYLOAD_MAX + sizeof(MsgHeader) > 32 * 1024
+                                       ? STATE_PAYLOAD_MAX + sizeof(MsgHeader) : 32 * 1024;
+constexpr size_t SPECTATOR_READ_BUFFER = SNAPSHOT_PAYLOAD_MAX + sizeof(MsgHeader) > 8 * 1024
+                                             ? SNAPSHOT_PAYLOAD_MAX + sizeof(MsgHeader)
+                                             : 8 * 1024;
+
+struct Bot {
+    int table_id;
+    int player_id;
+    int fd_in;    // server -> bot (player's _out FIFO, or the socket)
+    int fd_out;   // bot -> server (player's _in FIFO, or the socket)
+    std::string name;   // socket bots only
+    std::unique_ptr<MsgReader<BOT_READ_BUFFER>> reader;
+};
+
+struct TableStats {
+    long long last_roll_ns;   // when the last ROLL at this table was sent
+};
+
+// A ROLL waiting out its think time: (due time, bot index)
+using PendingRoll = std::pair<long long, int>;
+
+// Spectator connection; slow ones never read and only fill their socket
+struct Spectator {
+    int fd;
+    std::unique_ptr<MsgReader<SPECTATOR_READ_BUFFER>> reader;
+};
+
+constexpr uint32_t SPECTATOR_BIT = 1u << 31;   // epoll key flag for spectators
+
+volatile sig_atomic_t g_stop = 0;
+
+void sigint_handler(int) {
+    g_stop = 1;
+}
+
+/* ========================================
+   SERVER CPU - Players per Core
+   ======================================== */
+// CPU time (seconds) used so far by every process named "server": the
+// server and, in fork mode, its handlers. A handler that exits takes its
+// time with it, so churn in fork mode reads a little low.
+double server_cpu_seconds() {
+    DIR* proc = opendir("/proc");
+    if (!proc) return 0;
+
+    unsigned long long ticks = 0;
+    while (dirent* entry = readdir(proc)) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+        std::string path = std::string("/proc/") + entry->d_name + "/stat";
+        char line[512];
+        FILE* file = fopen(path.c_str(), "r");
+        if (!file) continue;   // exited meanwhile
+        bool got = fgets(line, sizeof(line), file) != nullptr;
+        fclose(file);
+
+        // "pid (comm) state ppid ...": utime and stime are fields 14 and 15
+        char* comm = strchr(line, '(');
+        char* rest = strrchr(line, ')');
+        if (!got || !comm || !rest || strncmp(comm, "(server)", rest + 1 - comm) != 0) continue;
+        unsigned long long utime, stime;
+        if (sscanf(rest + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu",
+                   &utime, &stime) == 2)
+            ticks += utime + stime;
+    }
+    closedir(proc);
+    return static_cast<double>(ticks) / sysconf(_SC_CLK_TCK);
+}
+
+/* ========================================
+   CONNECT
+   ======================================== */
+// The server must already be running: its handlers/reactors hold the
+// read end of every _in FIFO, so a non-blocking write open succeeds.
+bool connect_bot(Bot& bot) {
+    std::string in_fifo  = fifo_path(bot.table_id, bot.player_id, "out");
+    std::string out_fifo = fifo_path(bot.table_id, bot.player_id, "in");
+
+    for (int attempt = 0; attempt < 50; attempt++) {
+        bot.fd_in  = open(in_fifo.c_str(), O_RDONLY | O_NONBLOCK);
+        bot.fd_out = open(out_fifo.c_str(), O_WRONLY | O_NONBLOCK);
+        if (bot.fd_in >= 0 && bot.fd_out >= 0) {
+            send_msg(bot.fd_out, MSG_HELLO);   // takes the seat back if it went idle
+            return true;
+        }
+
+        if (bot.fd_in >= 0) close(bot.fd_in);
+        if (bot.fd_out >= 0) close(bot.fd_out);
+        usleep(100000);
+    }
+    return false;
+}
+
+// Join through the player socket and wait for the seat. Returns false if
+// the server refused; *rejoined is set if the bot got its old seat back.
+bool join_bot(Bot& bot, bool* rejoined) {
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, PLAYER_SOCKET, sizeof(addr.sun_path) - 1);
+
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        if (fd >= 0) close(fd);
+        return false;
+    }
+
+    send_msg(fd, MSG_JOIN, bot.name.data(), bot.name.size());
+
+    bot.reader->reset();
+    MsgView msg;
+    if (bot.reader->fill(fd) <= 0 || !bot.reader->next(msg) || msg.type != MSG_WELCOME ||
+        msg.length < sizeof(WelcomeMsg)) {
+        close(fd);
+        return false;
+    }
+
+    WelcomeMsg welcome;
+    std::memcpy(&welcome, msg.payload, sizeof(welcome));
+    bot.table_id = welcome.table_id;
+    bot.player_id = welcome.player_id;
+    bot.fd_in = bot.fd_out = fd;
+    *rejoined = welcome.reconnected;
+
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    return true;
+}
+
+int connect_spectator(int table_id) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, SPECTATOR_SOCKET, sizeof(addr.sun_path) - 1);
+
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+
+    WatchMsg watch{table_id};
+    send_msg(fd, MSG_WATCH, &watch, sizeof(watch));
+    return fd;
+}
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [-t tables] [-p players per table] [-f first table]"
+              << " [-d think ms] [-s seconds] [-w viewers,...] [-S slow viewers] [-m] [-a afk]"
+              << " [-N deaf]\n"
+              << "  -w  run one phase of -s seconds per listed spectator count\n"
+              << "  -S  spectators that never read, attached in every phase\n"
+              << "  -m  bots take shared-memory views (no STATE frames, see client -m)\n"
+              << "  -j  bots join through the player socket (-t/-p: how many to seat)\n"
+              << "  -C  with -j: bots hung up and rejoined per second, by name\n"
+              << "  -a  bots (the first N) that never roll, for the server's turn deadlines\n"
+              << "  -N  bots (the last N) that never read, for the server's outbound queues\n";
+}
+
+/* ========================================
+   MAIN LOAD GENERATOR
+   ======================================== */
+int main(int argc, char* argv[]) {
+    int num_tables = 1;
+    int num_players = 3;
+    int first_table = 0;
+    int think_ms = 0;
+    int seconds = 10;
+    std::vector<int> phases = {0};
+    int slow_viewers = 0;
+    bool shm_view = false;
+    bool join = false;
+    int churn_rate = 0;
+    int afk_bots = 0;
+    int deaf_bots = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:p:f:d:s:w:S:mjC:a:N:")) != -1) {
+        switch (opt) {
+        case 't': num_tables = atoi(optarg); break;
+        case 'p': num_players = atoi(optarg); break;
+        case 'f': first_table = atoi(optarg); break;
+        case 'd': think_ms = atoi(optarg); break;
+        case 's': seconds = atoi(optarg); break;
+        case 'w':
+            phases.clear();
+            for (char* tok = strtok(optarg, ","); tok; tok = strtok(nullptr, ","))
+                phases.push_back(atoi(tok));
+            break;
+        case 'S': slow_viewers = atoi(optarg); break;
+        case 'm': shm_view = true; break;
+        case 'j': join = true; break;
+        case 'C': churn_rate = atoi(optarg); break;
+        case 'a': afk_bots = atoi(optarg); break;
+        case 'N': deaf_bots = atoi(optarg); break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+
+    if (num_tables < 1 || first_table < 0 || first_table + num_tables > MAX_TABLES ||
+        num_players < 1 || num_players > MAX_PLAYERS || think_ms < 0 || seconds < 1 ||
+        phases.empty() || slow_viewers < 0 || churn_rate < 0 || (churn_rate && !join) ||
+        afk_bots < 0 || deaf_bots < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    signal(SIGINT, sigint_handler);
+    signal(SIGPIPE, SIG_IGN);
+
+    /* ---------- CONNECT BOTS ---------- */
+    int epoll_fd = epoll_create1(0);
+    std::vector<Bot> bots(num_tables * num_players);
+    std::unordered_map<int, TableStats> tables;   // by table id
+    int deaf_from = static_cast<int>(bots.size()) - deaf_bots;   // first bot that never reads
+
+    for (int t = 0; t < num_tables; t++) {
+        for (int p = 0; p < num_players; p++) {
+            int index = t * num_players + p;
+            Bot& bot = bots[index];
+            bot.table_id = first_table + t;
+            bot.player_id = p;
+            bot.reader.reset(new MsgReader<BOT_READ_BUFFER>);
+
+            bool rejoined;
+            bot.name = "bot" + std::to_string(getpid()) + "_" + std::to_string(index);
+            if (join ? !join_bot(bot, &rejoined) : !connect_bot(bot)) {
+                std::cerr << "[LOADGEN] Cannot connect table " << bot.table_id
+                          << " player " << p << " (is the server running?)\n";
+                return 1;
+            }
+            if (shm_view) send_msg(bot.fd_out, MSG_SHM_VIEW);
+            if (index >= deaf_from) continue;   // holds its seat, never reads it
+
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.u32 = index;
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, bot.fd_in, &ev);
+        }
+    }
+
+    std::cout << "[LOADGEN] " << bots.size() << " bots on " << num_tables << " table(s), think "
+              << think_ms << " ms, running " << seconds << " s"
+              << (shm_view ? ", shared-memory views" : "")
+              << (join ? ", joined by socket" : "")
+              << (afk_bots ? ", " + std::to_string(afk_bots) + " never rolling" : "")
+              << (deaf_bots ? ", " + std::to_string(deaf_bots) + " never reading" : "") << "\n";
+
+    /* ---------- EVENT LOOP ---------- */
+    LatencyHistogram turn_latency{};
+    long long turns = 0, games = 0, frames = 0, timeouts = 0;
+    long long rejoins = 0, rejoined_seat = 0, rejoin_failed = 0;
+    LatencyHistogram admission{};   // connect -> MSG_WELCOME, churn rejoins only
+    long long next_churn_ns = 0;
+    size_t churn_next = 0;
+    std::priority_queue<PendingRoll, std::vector<PendingRoll>, std::greater<PendingRoll>> pending;
+    std::vector<Spectator> viewers;
+    epoll_event events[256];
+
+    // The server hung up (or stopped): forget the bot, its descriptor
+    // would otherwise report EOF to every epoll_wait
+    int connected = static_cast<int>(bots.size());
+    long long hangups = 0;
+    auto drop_bot = [&](int index) {
+        Bot& bot = bots[index];
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, bot.fd_in, nullptr);
+        close(bot.fd_in);
+        if (bot.fd_out != bot.fd_in) close(bot.fd_out);
+        bot.fd_in = bot.fd_out = -1;
+        connected--;
+        hangups++;
+    };
+
+    auto send_roll = [&](int index) {
+        Bot& bot = bots[index];
+        if (bot.fd_out < 0) return;   // hung up while thinking
+        tables[bot.table_id].last_roll_ns = monotonic_ns();
+        send_msg(bot.fd_out, MSG_ROLL);
+        if (shm_view) turns++;   // no STATE frames to count
+    };
+
+    // Churn: hang up one bot and rejoin under the same name
+    auto rejoin_bot = [&](int index) {
+        Bot& bot = bots[index];
+        if (bot.fd_in >= 0) {
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, bot.fd_in, nullptr);
+            close(bot.fd_in);
+            connected--;
+        }
+        bot.fd_in = bot.fd_out = -1;
+
+        long long start = monotonic_ns();
+        bool rejoined = false;
+        if (!join_bot(bot, &rejoined)) {
+            rejoin_failed++;
+            return false;
+        }
+        hist_record(&admission, monotonic_ns() - start);
+        rejoins++;
+        connected++;
+        if (rejoined) rejoined_seat++;
+        if (shm_view) send_msg(bot.fd_out, MSG_SHM_VIEW);
+        if (index >= deaf_from) return true;
+
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u32 = index;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, bot.fd_in, &ev);
+        return true;
+    };
+
+    // Spectators are spread over the driven tables; slow ones are never
+    // registered with epoll
+    auto add_spectator = [&](bool slow) {
+        int table_id = bots[(viewers.size() % num_tables) * num_players].table_id;
+        int fd = connect_spectator(table_id);
+        if (fd < 0) return false;
+
+        viewers.push_back({fd, nullptr});
+        if (slow) return true;
+
+        viewers.back().reader.reset(new MsgReader<SPECTATOR_READ_BUFFER>);
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u32 = SPECTATOR_BIT | static_cast<uint32_t>(viewers.size() - 1);
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+        return true;
+    };
+
+    for (int s = 0; s < slow_viewers; s++) {
+        if (!add_spectator(true)) {
+            std::cerr << "[LOADGEN] Cannot connect spectator\n";
+            return 1;
+        }
+    }
+
+    struct PhaseResult { int viewers; double turns_per_s, p50, p99, frames_per_s, per_core; };
+    std::vector<PhaseResult> summary;
+
+    for (int phase_viewers : phases) {
+        while (static_cast<int>(viewers.size()) < slow_viewers + phase_viewers) {
+            if (!add_spectator(false)) {
+                std::cerr << "[LOADGEN] Cannot connect spectator\n";
+                return 1;
+            }
+        }
+        if (phase_viewers > 0 || slow_viewers > 0)
+            std::cout << "[LOADGEN] Phase: " << phase_viewers << " spectator(s)"
+                      << (slow_viewers ? " + " + std::to_string(slow_viewers) + " slow" : "") << "\n";
+
+        turn_latency = LatencyHistogram{};
+        admission = LatencyHistogram{};
+        turns = games = frames = timeouts = 0;
+        rejoins = rejoined_seat = rejoin_failed = 0;
+        hangups = 0;
+
+        double start_cpu = server_cpu_seconds();
+        long long start_ns = monotonic_ns();
+        long long end_ns = start_ns + seconds * 1000000000LL;
+        long long churn_period = churn_rate ? 1000000000LL / churn_rate : 0;
+        next_churn_ns = churn_rate ? start_ns + churn_period : end_ns;
+
+        while (!g_stop) {
+            long long now = monotonic_ns();
+            if (now >= end_ns) break;
+            if (connected == 0) {
+                std::cout << "[LOADGEN] The server hung up on every bot\n";
+                g_stop = 1;
+                break;
+            }
+
+            // Wake for the earliest think-time expiry, or at the end of the run
+            long long wake = std::min(end_ns, next_churn_ns);
+            if (!pending.empty()) wake = std::min(wake, pending.top().first);
+            int timeout_ms = static_cast<int>((wake - now + 999999) / 1000000);
+
+            int n = epoll_wait(epoll_fd, events, 256, timeout_ms);
+            now = monotonic_ns();
+
+            for (int e = 0; e < n; e++) {
+                uint32_t key = events[e].data.u32;
+                MsgView msg;
+
+                if (key & SPECTATOR_BIT) {
+                    Spectator& viewer = viewers[key & ~SPECTATOR_BIT];
+                    ssize_t bytes = viewer.reader->fill(viewer.fd);
+                    if (bytes == 0 || (bytes < 0 && errno != EAGAIN)) {
+                        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, viewer.fd, nullptr);
+                        close(viewer.fd);
+                        viewer.fd = -1;
+                    }
+                    if (bytes <= 0) continue;
+                    while (viewer.reader->next(msg)) {
+                        if (msg.type == MSG_SNAPSHOT) frames++;
+                    }
+                    if (viewer.reader->error) viewer.reader->reset();
+                    continue;
+                }
+
+                int index = key;
+                Bot& bot = bots[index];
+                TableStats& table = tables[bot.table_id];
+
+                if (bot.fd_in < 0) continue;   // dropped earlier in this batch
+                ssize_t bytes = bot.reader->fill(bot.fd_in);
+                if (bytes == 0 || (bytes < 0 && errno != EAGAIN)) drop_bot(index);
+                if (bytes <= 0) continue;
+                long long received_ns = monotonic_ns();
+
+                while (bot.reader->next(msg)) {
+                    switch (msg.type) {
+                    case MSG_YOUR_TURN:
+                        // Turn latency: previous ROLL sent -> this prompt received
+                        if (table.last_roll_ns && table.last_roll_ns < received_ns) {
+                            hist_record(&turn_latency, received_ns - table.last_roll_ns);
+                            table.last_roll_ns = 0;
+                        }
+                        if (index < afk_bots) break;
+                        if (think_ms == 0) send_roll(index);
+                        else pending.emplace(received_ns + think_ms * 1000000LL, index);
+                        break;
+                    case MSG_TIMEOUT:
+                        timeouts++;
+                        break;
+                    case MSG_STATE:
+                        if (bot.player_id == 0) turns++;   // one STATE per roll reaches every seat
+                        break;
+                    case MSG_GAME_OVER:
+                        if (bot.player_id == 0) games++;
+                        table.last_roll_ns = 0;            // next prompt waits out the reset pause
+                        break;
+                    default:
+                        break;
+                    }
+                }
+                if (bot.reader->error) bot.reader->reset();
+            }
+
+            while (!pending.empty() && pending.top().first <= now) {
+                send_roll(pending.top().second);
+                pending.pop();
+            }
+
+            while (churn_rate && next_churn_ns <= now) {
+                rejoin_bot(churn_next++ % bots.size());
+                next_churn_ns += churn_period;
+            }
+        }
+
+        /* ---------- REPORT ---------- */
+        double elapsed = (monotonic_ns() - start_ns) / 1e9;
+        double cores = std::max(0.0, server_cpu_seconds() - start_cpu) / elapsed;   // server CPUs busy
+        double per_core = cores > 0 ? bots.size() / cores : 0;
+
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "[LOADGEN] turns: " << turns << " (" << turns / elapsed << "/s)"
+                  << "  games: " << games << " (" << games / elapsed << "/s)\n";
+        std::cout << "[LOADGEN] turn latency (ROLL sent -> next YOUR_TURN): "
+                  << "p50 " << hist_percentile(&turn_latency, 50.0) / 1000.0 << " us  "
+                  << "p99 " << hist_percentile(&turn_latency, 99.0) / 1000.0 << " us  "
+                  << "p99.9 " << hist_percentile(&turn_latency, 99.9) / 1000.0 << " us  "
+                  << "(" << hist_count(&turn_latency) << " samples)\n";
+        std::cout << "[LOADGEN] server CPU: " << std::setprecision(2) << cores << " cores busy, "
+                  << std::setprecision(1) << per_core << " players per core\n";
+        if (hangups > 0)
+            std::cout << "[LOADGEN] bots hung up on by the server: " << hangups << "\n";
+        if (afk_bots > 0)
+            std::cout << "[LOADGEN] turn deadlines missed: " << timeouts << " ("
+                      << timeouts / elapsed << "/s)\n";
+        if (phase_viewers > 0)
+            std::cout << "[LOADGEN] spectator frames: " << frames << " ("
+                      << frames / elapsed << "/s)\n";
+        if (churn_rate) {
+            std::cout << "[LOADGEN] churn: " << rejoins << " rejoins (" << rejoins / elapsed
+                      << "/s), " << rejoined_seat << " back in their seat, "
+                      << rejoin_failed << " refused\n";
+            std::cout << "[LOADGEN] rejoin latency (connect -> WELCOME): "
+                      << "p50 " << hist_percentile(&admission, 50.0) / 1000.0 << " us  "
+                      << "p99 " << hist_percentile(&admission, 99.0) / 1000.0 << " us\n";
+        }
+
+        summary.push_back({phase_viewers, turns / elapsed,
+                           hist_percentile(&turn_latency, 50.0) / 1000.0,
+                           hist_percentile(&turn_latency, 99.0) / 1000.0, frames / elapsed,
+                           per_core});
+        if (g_stop) break;
+    }
+
+    if (summary.size() > 1) {
+        std::cout << "[LOADGEN] viewers   turns/s   p50 us   p99 us  frames/s  players/core\n";
+        for (const PhaseResult& r : summary) {
+            std::cout << "[LOADGEN] " << std::setw(7) << r.viewers << std::setw(10) << r.turns_per_s
+                      << std::setw(9) << r.p50 << std::setw(9) << r.p99
+                      << std::setw(10) << r.frames_per_s << std::setw(14) << r.per_core << "\n";
+        }
+    }
+
+    for (Bot& bot : bots) {
+        if (bot.fd_in < 0) continue;
+        close(bot.fd_in);
+        if (bot.fd_out != bot.fd_in) close(bot.fd_out);
+    }
+    for (Spectator& viewer : viewers)
+        if (viewer.fd >= 0) close(viewer.fd);
+    close(epoll_fd);
+    return 0;
+}
@@ -0,0 +1,133 @@
+#ifndef LOG_RING_HPP
+#define LOG_RING_HPP
+
+#include <atomic>
+#include <climits>
+#include <cstdarg>
+#include <cstdio>
+#include <semaphore.h>
+#include <sys/uio.h>
+
+constexpr unsigned LOG_RING_SLOTS = 512;   // must be a power of two
+constexpr int LOG_MSG_LEN = 256;
+
+// ---- Log Slot ----
+// seq == index        -> free, producer may claim it
+// seq == index + 1    -> filled, consumer may drain it
+// Line-aligned so producers filling neighbouring slots never share a line.
+struct alignas(64) LogSlot {
+    std::atomic<unsigned> seq;
+    int len;
+    char text[LOG_MSG_LEN];
+};
+
+// ---- Multi-producer / single-consumer ring (lives in shared memory) ----
+// Producers (forked handlers, scheduler) claim slots with a CAS on head and
+// never take a lock. The logger thread is the only consumer and owns tail.
+// Producer-written fields (head, dropped, wakeup) and the consumer's tail
+// each get their own cache line.
+struct LogRing {
+    alignas(64) std::atomic<unsigned> head;
+    alignas(64) unsigned tail;
+    alignas(64) std::atomic<unsigned> dropped;   // entries lost because the ring was full
+    alignas(64) sem_t wakeup;                    // posted once per published entry
+    LogSlot slots[LOG_RING_SLOTS];
+};
+
+static_assert(std::atomic<unsigned>::is_always_lock_free,
+              "log ring needs address-free atomics to work across processes");
+
+inline void log_ring_init(LogRing* ring) {
+    ring->head.store(0);
+    ring->tail = 0;
+    ring->dropped.store(0);
+    for (unsigned i = 0; i < LOG_RING_SLOTS; i++)
+        ring->slots[i].seq.store(i);
+    sem_init(&ring->wakeup, 1, 0);
+}
+
+// Format one entry into the ring. Returns false (and counts a drop) if full.
+inline bool log_ring_vpush(LogRing* ring, const char* fmt, va_list ap) {
+    unsigned pos = ring->head.load(std::memory_order_relaxed);
+    LogSlot* slot;
+
+    while (true) {
+        slot = &ring->slots[pos & (LOG_RING_SLOTS - 1)];
+        unsigned seq = slot->seq.load(std::memory_order_acquire);
+        int diff = static_cast<int>(seq - pos);
+
+        if (diff == 0) {
+            if (ring->head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            ring->dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = ring->head.load(std::memory_order_relaxed);
+        }
+    }
+
+    int len = vsnprintf(slot->text, LOG_MSG_LEN - 1, fmt, ap);
+    if (len < 0) len = 0;
+    if (len > LOG_MSG_LEN - 2) len = LOG_MSG_LEN - 2;
+    slot->text[len++] = '\n';
+    slot->len = len;
+
+    slot->seq.store(pos + 1, std::memory_order_release);
+    sem_post(&ring->wakeup);
+    return true;
+}
+
+__attribute__((format(printf, 2, 3)))
+inline bool log_ring_push(LogRing* ring, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    bool ok = log_ring_vpush(ring, fmt, ap);
+    va_end(ap);
+    return ok;
+}
+
+// Consumer side: the next filled slot, or nullptr if the ring is empty
+// (or the oldest entry is still being written).
+inline LogSlot* log_ring_peek(LogRing* ring, unsigned offset) {
+    unsigned pos = ring->tail + offset;
+    LogSlot* slot = &ring->slots[pos & (LOG_RING_SLOTS - 1)];
+    if (slot->seq.load(std::memory_order_acquire) != pos + 1) return nullptr;
+    return slot;
+}
+
+// Consumer side: hand `count` drained slots back to the producers.
+inline void log_ring_release(LogRing* ring, unsigned count) {
+    for (unsigned i = 0; i < count; i++) {
+        unsigned pos = ring->tail + i;
+        ring->slots[pos & (LOG_RING_SLOTS - 1)].seq.store(pos + LOG_RING_SLOTS,
+                                                          std::memory_order_release);
+    }
+    ring->tail += count;
+}
+
+// Consumer side: write everything currently published to `fd` with one
+// writev() per batch. Returns the number of entries drained.
+inline int log_ring_drain(LogRing* ring, int fd) {
+    iovec iov[IOV_MAX];
+    int total = 0;
+
+    while (true) {
+        unsigned count = 0;
+        while (count < IOV_MAX) {
+            LogSlot* slot = log_ring_peek(ring, count);
+            if (!slot) break;
+            iov[count].iov_base = slot->text;
+            iov[count].iov_len = slot->len;
+            count++;
+        }
+        if (count == 0) break;
+
+        if (writev(fd, iov, count) < 0) perror("writev log");
+        log_ring_release(ring, count);
+        total += count;
+    }
+    return total;
+}
+
+#endif
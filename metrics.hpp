@@ -0,0 +1,185 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "common.hpp"
+#include "histogram.hpp"
+
+// ---- Live metrics ----
+// A separate shared-memory segment next to SharedData. Every server process
+// or thread claims its own slot and is the only writer of it, so updates
+// are plain relaxed stores with no lock prefix and no shared cache lines.
+// The stats tool maps the segment read-only and sums the slots.
+constexpr const char* METRICS_SHM_NAME = "/race_game_metrics";
+constexpr uint32_t METRICS_MAGIC = 0x52414345;   // "RACE"
+constexpr uint32_t METRICS_VERSION = 9;
+constexpr int MAX_METRIC_SLOTS = 8192;
+constexpr int METRIC_ROLE_LEN = 16;
+
+struct alignas(64) MetricsSlot {
+    int pid;
+    int released;                    // its handler exited: not live, free to take over
+    char role[METRIC_ROLE_LEN];      // "handler", "logger", "scheduler", "reactor", "scorekeeper", "spectator", "listener", "supervisor"
+
+    // Turns
+    uint64_t turns;                  // rolls committed
+    LatencyHistogram handoff;        // roll commit -> next YOUR_TURN
+
+    // Lock waits (time to acquire, uncontended acquisitions count as 0)
+    LatencyHistogram game_mutex_wait;
+    LatencyHistogram log_mutex_wait;
+    LatencyHistogram score_mutex_wait;
+
+    // Broadcast
+    uint64_t broadcast_frames;
+    uint64_t broadcast_bytes;
+    uint64_t fifo_eagain;            // recipients whose FIFO was full (frame queued)
+
+    // Outbound queues (see out_queue.hpp, written by each client's owner)
+    uint64_t out_queued;             // frames queued because the client was behind
+    uint64_t out_partial;            // frames the client took part of, finished later
+    uint64_t out_coalesced;          // queued STATE frames replaced by a newer one
+    uint64_t out_depth;              // frames queued now
+    uint64_t out_depth_max;          // most frames queued for one client
+    uint64_t out_stuck;              // clients dropped with a full queue
+
+    // Logger (written by the logger thread only)
+    uint64_t log_written;
+    uint64_t log_batches;
+    uint64_t log_depth;              // entries pending at the last wakeup
+    uint64_t log_depth_max;
+    uint64_t log_dropped;            // mirror of LogRing::dropped
+
+    // Event log (written by the logger, dropped by whoever found the queue full)
+    uint64_t events_written;         // records appended to events-*.bin
+    uint64_t events_dropped;
+    uint64_t event_segment;          // number of the segment being written
+
+    // Score store (written by the scorekeeper thread only)
+    uint64_t score_events;           // wins journaled
+    uint64_t score_commits;          // write + fdatasync batches
+    LatencyHistogram score_commit;   // time per group commit
+
+    // Spectators (written by the spectator thread only)
+    uint64_t spectators;             // viewers attached now
+    uint64_t spectator_frames;       // snapshots handed to viewers
+    uint64_t spectator_bytes;
+    uint64_t spectator_coalesced;    // updates skipped while a viewer was behind
+
+    // Socket players (joins by the listener, leaves by the owning reactor)
+    uint64_t socket_joins;           // seated in a free or new seat
+    uint64_t socket_rejoins;         // back in the seat reserved for their name
+    uint64_t socket_leaves;
+    LatencyHistogram admission;      // MSG_JOIN received -> MSG_WELCOME sent
+
+    // Crash recovery
+    uint64_t handler_respawns;       // handlers started in the seat of a crashed one
+    uint64_t lock_repairs;           // game_mutex taken over from a dead owner
+
+    // Turn deadlines (written by whoever serves the seat on turn)
+    uint64_t deadlines_expired;      // turns the player did not roll in time
+    uint64_t deadline_rolls;         // ... rolled by the server for them
+    uint64_t deadline_skips;         // ... skipped
+    uint64_t idle_seats;             // seats marked disconnected after repeated misses
+    uint64_t idle_returns;           // idle players back after sending input
+};
+
+struct MetricsBlock {
+    uint32_t magic;
+    uint32_t version;
+    long long start_ns;
+    std::atomic<int> num_slots;
+    MetricsSlot slots[MAX_METRIC_SLOTS];
+};
+
+// Slot for the calling thread. Points at a private scratch slot until
+// metrics_attach() succeeds, so instrumentation never needs a null check.
+inline MetricsSlot g_metrics_scratch;
+inline thread_local MetricsSlot* t_metrics = &g_metrics_scratch;
+
+// Claim a slot for the calling thread (call again in a forked child).
+// A slot of the same role released by metrics_release() is taken over
+// first, counters and all, so handlers that come and go (respawns,
+// players rejoining) do not use up the segment.
+inline void metrics_attach(MetricsBlock* block, const char* role) {
+    t_metrics = &g_metrics_scratch;
+    if (!block) return;
+
+    int claimed = std::min(block->num_slots.load(), MAX_METRIC_SLOTS);
+    for (int i = 0; i < claimed; i++) {
+        MetricsSlot* slot = &block->slots[i];
+        int released = 1;
+        if (__atomic_load_n(&slot->released, __ATOMIC_ACQUIRE) &&
+            strncmp(slot->role, role, METRIC_ROLE_LEN) == 0 &&
+            __atomic_compare_exchange_n(&slot->released, &released, 0, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            __atomic_store_n(&slot->pid, getpid(), __ATOMIC_RELEASE);
+            t_metrics = slot;
+            return;
+        }
+    }
+
+    int index = block->num_slots.fetch_add(1);
+    if (index >= MAX_METRIC_SLOTS) return;
+
+    MetricsSlot* slot = &block->slots[index];
+    strncpy(slot->role, role, METRIC_ROLE_LEN - 1);
+    __atomic_store_n(&slot->pid, getpid(), __ATOMIC_RELEASE);
+    t_metrics = slot;
+}
+
+// The process `pid` exited (the parent reaped it). Its slot stops counting
+// as live and is handed to the next process that attaches with the same
+// role; its counters stay in the totals, its queue depth is gone with it.
+inline void metrics_release(MetricsBlock* block, int pid) {
+    if (!block) return;
+    int claimed = std::min(block->num_slots.load(), MAX_METRIC_SLOTS);
+    for (int i = 0; i < claimed; i++) {
+        MetricsSlot* slot = &block->slots[i];
+        if (__atomic_load_n(&slot->pid, __ATOMIC_ACQUIRE) != pid ||
+            __atomic_load_n(&slot->released, __ATOMIC_RELAXED))
+            continue;
+        __atomic_store_n(&slot->out_depth, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&slot->released, 1, __ATOMIC_RELEASE);
+        return;
+    }
+}
+
+// Single-writer updates: readers may see them slightly late, never torn
+inline void metric_add(uint64_t* counter, uint64_t value = 1) {
+    __atomic_store_n(counter, *counter + value, __ATOMIC_RELAXED);
+}
+
+inline void metric_set(uint64_t* gauge, uint64_t value) {
+    __atomic_store_n(gauge, value, __ATOMIC_RELAXED);
+}
+
+inline void metric_record(LatencyHistogram* h, uint64_t ns) {
+    uint64_t* bucket = &h->counts[hist_bucket(ns)];
+    __atomic_store_n(bucket, *bucket + 1, __ATOMIC_RELAXED);
+}
+
+// pthread_mutex_lock that records how long the acquisition took. The
+// uncontended path is a trylock and costs no clock reads. Returns the
+// lock result: EOWNERDEAD means the mutex is held but its previous owner
+// died holding it, and the caller must repair what it guards.
+inline int metrics_lock(pthread_mutex_t* mutex, LatencyHistogram* wait) {
+    int rc = pthread_mutex_trylock(mutex);
+    if (rc != EBUSY) {
+        metric_record(wait, 0);
+        return rc;
+    }
+    long long start = monotonic_ns();
+    rc = pthread_mutex_lock(mutex);
+    metric_record(wait, monotonic_ns() - start);
+    return rc;
+}
+
+#endif
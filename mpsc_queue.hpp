@@ -0,0 +1,65 @@
+#ifndef MPSC_QUEUE_HPP
+#define MPSC_QUEUE_HPP
+
+#include <atomic>
+
+// ---- Bounded multi-producer / single-consumer queue ----
+// Same slot-sequence scheme as LogRing, for small trivially copyable values.
+// Lives in shared memory: call init() once before any process uses it.
+template <typename T, unsigned N>
+struct MpscQueue {
+    static_assert((N & (N - 1)) == 0, "capacity must be a power of two");
+
+    struct Cell {
+        std::atomic<unsigned> seq;
+        T value;
+    };
+
+    alignas(64) std::atomic<unsigned> head;
+    alignas(64) unsigned tail;
+    Cell cells[N];
+
+    void init() {
+        head.store(0);
+        tail = 0;
+        for (unsigned i = 0; i < N; i++) cells[i].seq.store(i);
+    }
+
+    // Producer side. Returns false if the queue is full.
+    bool push(const T& value) {
+        unsigned pos = head.load(std::memory_order_relaxed);
+        Cell* cell;
+
+        while (true) {
+            cell = &cells[pos & (N - 1)];
+            unsigned seq = cell->seq.load(std::memory_order_acquire);
+            int diff = static_cast<int>(seq - pos);
+
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = value;
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false if nothing is ready.
+    bool pop(T& value) {
+        Cell* cell = &cells[tail & (N - 1)];
+        if (cell->seq.load(std::memory_order_acquire) != tail + 1) return false;
+
+        value = cell->value;
+        cell->seq.store(tail + N, std::memory_order_release);
+        tail++;
+        return true;
+    }
+};
+
+#endif
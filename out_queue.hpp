@@ -0,0 +1,177 @@
+#ifndef OUT_QUEUE_HPP
+#define OUT_QUEUE_HPP
+
+#include <cerrno>
+#include <deque>
+#include <string>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "metrics.hpp"
+#include "protocol.hpp"
+
+// ---- Outbound queue ----
+// Frames on their way to one client, kept by the only thread or process
+// that writes to the client's descriptor (the reactor owning the table,
+// or the seat's handler in fork mode). A frame the client cannot take
+// right now, or takes only part of, is queued and finished before
+// anything sent after it, so frames are never torn or interleaved
+// whatever their size (a FIFO is only atomic up to PIPE_BUF).
+//
+// Control frames (YOUR_TURN, WIN, GAME_OVER, TIMEOUT) are kept until they
+// are written. A STATE frame is only a picture of the table: a newer one
+// replaces the one still queued, so a slow reader holds at most one of
+// them plus whatever it has half read, and a full queue drops STATE
+// frames before it refuses anything else. A client whose control frames
+// alone fill OUT_QUEUE_MAX_FRAMES is reported as stuck to the owner, which
+// disconnects it: the queue is never emptied behind the client's back.
+constexpr size_t OUT_QUEUE_MAX_FRAMES = 256;
+
+struct OutFrame {
+    std::string bytes;
+    bool state;          // STATE frame not started yet: may be replaced
+};
+
+struct OutQueue {
+    std::deque<OutFrame> frames;
+    size_t sent = 0;     // bytes of frames.front() already written
+    bool armed = false;  // owner is waiting for the descriptor to be writable
+};
+
+inline bool out_pending(const OutQueue* q) {
+    return !q->frames.empty();
+}
+
+inline void out_depth_changed(long delta) {
+    metric_set(&t_metrics->out_depth, t_metrics->out_depth + delta);
+}
+
+// Forget everything queued (the client is gone, or a new one took the seat)
+inline void out_reset(OutQueue* q) {
+    out_depth_changed(-static_cast<long>(q->frames.size()));
+    q->frames.clear();
+    q->sent = 0;
+}
+
+// Drop the frames not started yet, keeping the rest of a half-written one
+// so a client that still holds the descriptor reads whole frames. For an
+// owner that disconnects a client it cannot close (a FIFO seat).
+inline void out_drop_unstarted(OutQueue* q) {
+    size_t keep = q->sent > 0 ? 1 : 0;
+    out_depth_changed(-static_cast<long>(q->frames.size() - keep));
+    q->frames.resize(keep);
+}
+
+// Make room in a full queue by dropping STATE frames that have not
+// started, oldest first. Returns false if only control frames are left.
+inline bool out_make_room(OutQueue* q) {
+    for (size_t i = 0; i < q->frames.size() && q->frames.size() >= OUT_QUEUE_MAX_FRAMES;) {
+        if (!q->frames[i].state || (i == 0 && q->sent > 0)) {
+            i++;
+            continue;
+        }
+        q->frames.erase(q->frames.begin() + i);
+        out_depth_changed(-1);
+        metric_add(&t_metrics->out_coalesced);
+    }
+    return q->frames.size() < OUT_QUEUE_MAX_FRAMES;
+}
+
+// Write queued frames, oldest first, until the queue is empty or the
+// descriptor is full. One write() per frame, so a SOCK_SEQPACKET client
+// still gets one frame per record. Returns false if the client is gone.
+inline bool out_flush(OutQueue* q, int fd) {
+    while (!q->frames.empty()) {
+        OutFrame& frame = q->frames.front();
+        ssize_t n = write(fd, frame.bytes.data() + q->sent, frame.bytes.size() - q->sent);
+        if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+
+        q->sent += n;
+        if (q->sent < frame.bytes.size()) {
+            if (frame.state) metric_add(&t_metrics->out_partial);
+            frame.state = false;   // started: the rest must follow as is
+            return true;
+        }
+        q->frames.pop_front();
+        q->sent = 0;
+        out_depth_changed(-1);
+    }
+    return true;
+}
+
+// Send one frame (gathered from `iov`). With nothing queued it is written
+// straight away and only what the client did not take is copied; behind
+// a queue it waits its turn. `state`: a STATE frame, replacing any
+// queued one that has not started, and itself dropped if control frames
+// fill the queue. Returns the bytes written now, or -1 if the client is
+// gone or stuck (a control frame found no room).
+inline ssize_t out_send(OutQueue* q, int fd, const iovec* iov, int iovcnt, bool state) {
+    size_t len = 0;
+    for (int i = 0; i < iovcnt; i++) len += iov[i].iov_len;
+
+    size_t written = 0;
+    if (q->frames.empty()) {
+        ssize_t n = writev(fd, iov, iovcnt);
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) return -1;
+        if (n > 0) written = n;
+        if (written == len) return written;
+        if (written > 0) {
+            metric_add(&t_metrics->out_partial);
+            state = false;
+        }
+    } else if (state) {
+        for (size_t i = q->frames.size(); i-- > 0;) {
+            if (!q->frames[i].state || (i == 0 && q->sent > 0)) continue;
+            q->frames.erase(q->frames.begin() + i);
+            out_depth_changed(-1);
+            metric_add(&t_metrics->out_coalesced);
+        }
+    }
+
+    if (!out_make_room(q)) {
+        if (state) {
+            metric_add(&t_metrics->out_coalesced);
+            return written;
+        }
+        metric_add(&t_metrics->out_stuck);
+        return -1;
+    }
+
+    // Queue what is left of the frame
+    OutFrame frame;
+    frame.state = state;
+    frame.bytes.reserve(len - written);
+    size_t skip = written;
+    for (int i = 0; i < iovcnt; i++) {
+        const char* base = static_cast<const char*>(iov[i].iov_base);
+        size_t part = iov[i].iov_len;
+        if (skip >= part) {
+            skip -= part;
+            continue;
+        }
+        frame.bytes.append(base + skip, part - skip);
+        skip = 0;
+    }
+    q->frames.push_back(std::move(frame));
+    out_depth_changed(1);
+    metric_add(&t_metrics->out_queued);
+    if (q->frames.size() > t_metrics->out_depth_max)
+        metric_set(&t_metrics->out_depth_max, q->frames.size());
+
+    // Behind an older frame: it may have drained since
+    if (q->frames.size() > 1 && !out_flush(q, fd)) return -1;
+    return written;
+}
+
+// Control message: header and payload as one frame, never replaced
+inline bool out_send_msg(OutQueue* q, int fd, MsgType type, const void* payload = nullptr,
+                         uint32_t length = 0) {
+    MsgHeader hdr = make_header(type, length);
+    iovec iov[2] = {
+        { &hdr, sizeof(hdr) },
+        { const_cast<void*>(payload), length },
+    };
+    return out_send(q, fd, iov, length ? 2 : 1, false) >= 0;
+}
+
+#endif
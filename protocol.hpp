@@ -0,0 +1,201 @@
+#ifndef PROTOCOL_HPP
+#define PROTOCOL_HPP
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "race_track.hpp"
+
+// ---- Wire protocol ----
+// Every message is an 8-byte header followed by `length` payload bytes.
+// Messages are parsed in place from a reusable receive buffer, so several
+// can arrive in one read() (or one be split over several) without ambiguity.
+//
+// Server -> Client: MSG_YOUR_TURN, MSG_STATE, MSG_WIN, MSG_GAME_OVER, MSG_TIMEOUT
+// Client -> Server: MSG_HELLO (optional, first), MSG_SHM_VIEW (optional), MSG_ROLL
+// Spectators (SPECTATOR_SOCKET): MSG_WATCH in, MSG_SNAPSHOT out
+// Socket players (PLAYER_SOCKET): MSG_JOIN in, MSG_WELCOME out, then as above
+enum MsgType : uint8_t {
+    MSG_YOUR_TURN = 1,   // no payload
+    MSG_ROLL      = 2,   // no payload
+    MSG_STATE     = 3,   // StateDelta, then the rendered race track (text)
+    MSG_WIN       = 4,   // no payload, sent to the winner only
+    MSG_GAME_OVER = 5,   // GameOverMsg, sent to every seat
+    MSG_HELLO     = 6,   // player name (no terminator, may be empty), scores are kept per name
+    MSG_WATCH     = 7,   // WatchMsg: spectate a table (again to switch tables)
+    MSG_SNAPSHOT  = 8,   // SnapshotMsg, num_players int32 positions, race track text
+    MSG_SHM_VIEW  = 9,   // no payload: client renders from shared memory, stop STATE frames
+    MSG_JOIN      = 10,  // player name or empty: ask the listener for a seat
+    MSG_WELCOME   = 11,  // WelcomeMsg: the seat the listener assigned
+    MSG_TIMEOUT   = 12,  // TimeoutMsg: the turn deadline passed before MSG_ROLL
+};
+
+// Spectators connect here (SOCK_STREAM) instead of taking a player seat
+constexpr const char* SPECTATOR_SOCKET = "/tmp/race_spectate.sock";
+
+// Players connect here (SOCK_SEQPACKET, one message per record) and are
+// given a seat, instead of opening a fixed seat's FIFOs
+constexpr const char* PLAYER_SOCKET = "/tmp/race_players.sock";
+
+struct MsgHeader {
+    uint32_t length;     // payload bytes after the header
+    uint8_t type;
+    uint8_t reserved[3];
+};
+
+struct StateDelta {
+    int32_t player_id;   // who rolled
+    int32_t dice;
+    int32_t position;    // their new position
+    int32_t winner;      // -1 while the game is running
+};
+
+struct GameOverMsg {
+    int32_t winner;
+};
+
+struct WatchMsg {
+    int32_t table_id;
+};
+
+struct WelcomeMsg {
+    int32_t table_id;
+    int32_t player_id;
+    int32_t num_players;
+    int32_t reconnected;  // 1: back in the seat this name held in the running game
+};
+
+struct TimeoutMsg {
+    int32_t rolled;      // 1: the server rolled for the player, 0: the turn was skipped
+    int32_t idle;        // 1: too many missed turns, seat skipped until the player sends input
+};
+
+// Latest state of a watched table. Spectators are sent the newest state
+// whenever they can take it, not every roll, so versions may skip.
+struct SnapshotMsg {
+    int32_t table_id;
+    uint32_t version;    // increases with every state change
+    int32_t current_turn;
+    int32_t winner;      // -1 while the game is running
+    int32_t game_active;
+    int32_t num_players; // positions that follow
+};
+
+// Fixed part of a STATE frame; the race track text follows it
+struct StateFrameHead {
+    MsgHeader hdr;
+    StateDelta delta;
+};
+
+struct GameOverFrame {
+    MsgHeader hdr;
+    GameOverMsg body;
+};
+
+// A frame may reach the reader in several writes: a client that takes
+// part of one gets the rest before any other frame, because each
+// descriptor has a single writer that queues what is left (out_queue.hpp).
+//
+// The rendered track grows with the seats a table has (make SEATS=n), so
+// the largest payloads are sized from it: a STATE frame and a SNAPSHOT of
+// a full table must fit every reader, or MsgReader::next() rejects them.
+constexpr size_t TRACK_FRAME_MAX = RaceTrack<WIN_POSITION>::FRAME_MAX;
+constexpr uint32_t STATE_PAYLOAD_MAX = sizeof(StateDelta) + TRACK_FRAME_MAX;
+constexpr uint32_t SNAPSHOT_PAYLOAD_MAX =
+    sizeof(SnapshotMsg) + MAX_PLAYERS * sizeof(int32_t) + TRACK_FRAME_MAX;
+constexpr uint32_t MAX_PAYLOAD = SNAPSHOT_PAYLOAD_MAX > 64 * 1024 ? SNAPSHOT_PAYLOAD_MAX
+                                                                  : 64 * 1024;
+static_assert(sizeof(StateFrameHead) + TRACK_FRAME_MAX <= STATE_FRAME_MAX,
+              "a full table's STATE frame must fit Table::frame");
+static_assert(MAX_PAYLOAD >= STATE_PAYLOAD_MAX && MAX_PAYLOAD >= SNAPSHOT_PAYLOAD_MAX,
+              "a full table's STATE and SNAPSHOT frames must fit MAX_PAYLOAD");
+
+inline MsgHeader make_header(MsgType type, uint32_t length) {
+    MsgHeader hdr{};
+    hdr.length = length;
+    hdr.type = type;
+    return hdr;
+}
+
+// Send one message with a single writev(). Returns false on a short write.
+inline bool send_msg(int fd, MsgType type, const void* payload = nullptr, uint32_t length = 0) {
+    MsgHeader hdr = make_header(type, length);
+    iovec iov[2] = {
+        { &hdr, sizeof(hdr) },
+        { const_cast<void*>(payload), length },
+    };
+    ssize_t n = writev(fd, iov, length ? 2 : 1);
+    return n == static_cast<ssize_t>(sizeof(hdr) + length);
+}
+
+// A parsed message; payload points into the reader's buffer and stays
+// valid until the next fill().
+struct MsgView {
+    uint8_t type;
+    uint32_t length;
+    const char* payload;
+};
+
+// ---- Receive buffer ----
+template <size_t N>
+struct MsgReader {
+    static_assert(N > sizeof(MsgHeader), "receive buffer too small");
+
+    char buf[N];
+    size_t start = 0;    // first unparsed byte
+    size_t end = 0;      // one past the last received byte
+    bool error = false;  // oversized or malformed frame
+
+    // Read whatever is available. Returns read()'s result.
+    ssize_t fill(int fd) {
+        // Rewind once everything is parsed, so a SOCK_SEQPACKET record
+        // always has the whole buffer and is never truncated
+        if (start == end) start = end = 0;
+
+        // Move a partial message to the front only when we run out of room
+        if (end == N && start > 0) {
+            std::memmove(buf, buf + start, end - start);
+            end -= start;
+            start = 0;
+        }
+        ssize_t n = read(fd, buf + end, N - end);
+        if (n > 0) end += n;
+        return n;
+    }
+
+    // Drop everything buffered (resync after a malformed frame)
+    void reset() {
+        start = end = 0;
+        error = false;
+    }
+
+    // Parse the next complete message, if any, without copying it.
+    bool next(MsgView& msg) {
+        if (end - start < sizeof(MsgHeader)) return compact();
+
+        MsgHeader hdr;
+        std::memcpy(&hdr, buf + start, sizeof(hdr));
+        if (hdr.length > MAX_PAYLOAD || sizeof(hdr) + hdr.length > N) {
+            error = true;
+            return false;
+        }
+        if (end - start < sizeof(hdr) + hdr.length) return compact();
+
+        msg.type = hdr.type;
+        msg.length = hdr.length;
+        msg.payload = buf + start + sizeof(hdr);
+        start += sizeof(hdr) + hdr.length;
+        return true;
+    }
+
+private:
+    bool compact() {
+        if (start == end) start = end = 0;
+        return false;
+    }
+};
+
+#endif
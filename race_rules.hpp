@@ -0,0 +1,27 @@
+#ifndef RACE_RULES_HPP
+#define RACE_RULES_HPP
+
+// ---- Race rules ----
+// The roll and win rules, shared by the server, the replay tool and the
+// simulator. They are templates so the same code runs on one int (the
+// server) or on a GCC vector of game lanes (the simulator), where the
+// comparison yields a lane mask instead of a bool.
+
+// Move a racer by the dice value
+template <typename Pos>
+inline Pos race_advance(Pos position, Pos dice) {
+    return position + dice;
+}
+
+// Reaching the goal or going past it wins
+template <typename Pos, typename Goal>
+inline auto race_won(Pos position, Goal goal) -> decltype(position >= goal) {
+    return position >= goal;
+}
+
+// Round Robin: seat after `seat`, wrapping to seat 0
+inline int race_next_seat(int seat, int num_players) {
+    return (seat + 1) % num_players;
+}
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef RACE_TRACK_HPP
+#define RACE_TRACK_HPP
+
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+
+#include "common.hpp"
+
+// ---- Race track ----
+// Text rendering of the track, used by the server for STATE and spectator
+// frames and by clients that render straight from shared memory.
+//
+// The goal is a compile-time parameter, so the shape of every line is
+// known up front. The three lines a racer takes up at each position are
+// rendered once per process; drawing a frame copies the header and one
+// template per racer into the renderer's own buffer and patches the
+// racer's number in. Nothing is formatted or allocated per frame.
+//
+//   P2 [07m]|------- -O- --------------------------------|
+//           |        | # |                                 |
+//           |------- -O- --------------------------------|
+template <int Goal>
+class RaceTrack {
+    static_assert(Goal >= 1 && Goal <= 99, "track positions are drawn with two digits");
+
+public:
+    // The view points into this renderer and is valid until the next call
+    std::string_view render(const int positions[], int num_players) {
+        const Templates& t = templates();
+        char* out = frame_;
+
+        std::memcpy(out, t.header, t.header_len);
+        out += t.header_len;
+        for (int p = 0; p < num_players; p++) {
+            int pos = positions[p];
+            if (pos > Goal) pos = Goal;
+            if (pos < 0) pos = 0;
+
+            const Row& row = t.rows[pos];
+            std::memcpy(out, row.text, row.len);
+            std::memcpy(out + 1, t.labels[p], LABEL_WIDTH);   // "P<n> [..m]"
+            out += row.len;
+        }
+        return std::string_view(frame_, out - frame_);
+    }
+
+private:
+    // Racer numbers are padded to the widest one, so every row lines up
+    static constexpr int LABEL_WIDTH = MAX_PLAYERS >= 1000 ? 4 : MAX_PLAYERS >= 100 ? 3
+                                     : MAX_PLAYERS >= 10 ? 2 : 1;
+    static constexpr int MARGIN = 7 + LABEL_WIDTH;              // "P<n> [..m]"
+    static constexpr int HEADER_MAX = 160;
+    static constexpr int ROW_MAX = 3 * (MARGIN + Goal + 10) + 1;   // three lines and a blank one
+
+public:
+    // Longest frame render() can return: a full table at the build's seat count
+    static constexpr size_t FRAME_MAX = HEADER_MAX + MAX_PLAYERS * ROW_MAX;
+
+private:
+
+    struct Row {
+        char text[ROW_MAX];
+        int len;
+    };
+
+    struct Templates {
+        char header[HEADER_MAX];
+        int header_len;
+        Row rows[Goal + 1];                      // by position, racer number left blank
+        char labels[MAX_PLAYERS][LABEL_WIDTH];   // by seat
+
+        Templates() {
+            header_len = 0;
+            put(header, &header_len, "===============================================\n");
+            put(header, &header_len, " RACE TRACK (Goal: ");
+            put_number(header, &header_len, Goal);
+            put(header, &header_len, "m)\n");
+            put(header, &header_len, "===============================================\n\n");
+
+            for (int pos = 0; pos <= Goal; pos++) {
+                char* text = rows[pos].text;
+                int* len = &rows[pos].len;
+                *len = 0;
+
+                text[(*len)++] = 'P';
+                fill(text, len, ' ', LABEL_WIDTH);
+                put(text, len, " [");
+                text[(*len)++] = static_cast<char>('0' + pos / 10);
+                text[(*len)++] = static_cast<char>('0' + pos % 10);
+                put(text, len, "m]|");
+                line(text, len, pos, '-', " -O- ");
+                put(text, len, "|\n");
+                fill(text, len, ' ', MARGIN);
+                put(text, len, "|");
+                line(text, len, pos, ' ', " | # | ");
+                put(text, len, "|\n");
+                fill(text, len, ' ', MARGIN);
+                put(text, len, "|");
+                line(text, len, pos, '-', " -O- ");
+                put(text, len, "|\n\n");
+            }
+
+            for (int p = 0; p < MAX_PLAYERS; p++) {
+                int len = 0;
+                put_number(labels[p], &len, p + 1);
+                std::memset(labels[p] + len, ' ', LABEL_WIDTH - len);
+            }
+        }
+
+        static void put(char* buf, int* len, const char* s) {
+            size_t n = std::strlen(s);
+            std::memcpy(buf + *len, s, n);
+            *len += static_cast<int>(n);
+        }
+
+        static void put_number(char* buf, int* len, int value) {
+            if (value >= 10) put_number(buf, len, value / 10);
+            buf[(*len)++] = static_cast<char>('0' + value % 10);
+        }
+
+        static void fill(char* buf, int* len, char c, int count) {
+            if (count <= 0) return;
+            std::memset(buf + *len, c, count);
+            *len += count;
+        }
+
+        // `c` up to the racer, the racer, `c` on to the goal
+        static void line(char* buf, int* len, int pos, char c, const char* racer) {
+            fill(buf, len, c, pos);
+            put(buf, len, racer);
+            fill(buf, len, c, Goal - pos - 1);
+        }
+    };
+
+    // Built on first use, shared by every renderer for this goal
+    static const Templates& templates() {
+        static const Templates t;
+        return t;
+    }
+
+    char frame_[HEADER_MAX + MAX_PLAYERS * ROW_MAX];
+};
+
+// ---- Leaderboard ----
+// The server's console leaderboard, in the order the table's Ranking
+// keeps (see ranking_update), formatted into the caller's buffer of
+// LEADERBOARD_TEXT_MAX bytes. Returns the length.
+constexpr int LEADERBOARD_TEXT_MAX = 128 + MAX_PLAYERS * 48;
+
+// English ordinal suffix: 1st 2nd 3rd 4th ... 11th 12th 13th ... 21st
+inline const char* ordinal_suffix(int n)
+{
+    if (n % 100 >= 11 && n % 100 <= 13) return "th";
+    switch (n % 10)
+    {
+    case 1: return "st";
+    case 2: return "nd";
+    case 3: return "rd";
+    default: return "th";
+    }
+}
+
+inline int format_leaderboard(char* text, const int positions[], const uint16_t order[],
+                              int num_players)
+{
+    int len = snprintf(text, LEADERBOARD_TEXT_MAX,
+                       "=================================================\n LEADERBOARD:\n");
+
+    for (int rank = 0; rank < num_players; ++rank)
+    {
+        len += snprintf(text + len, LEADERBOARD_TEXT_MAX - len,
+                        " %d%s: PLAYER %d (Distance: %d)\n", rank + 1, ordinal_suffix(rank + 1),
+                        order[rank] + 1, positions[order[rank]]);
+    }
+    len += snprintf(text + len, LEADERBOARD_TEXT_MAX - len,
+                    "==================================================\n");
+    return len;
+}
+
+#endif
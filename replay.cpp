@@ -0,0 +1,68 @@
+#include <iostream>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstdint>
+
+#include "common.hpp"
+#include "dice_rng.hpp"
+#include "race_rules.hpp"
+
+// Replays one game from the seed the server logged for it:
+//
+//   Table 3: game 17 seed 0x5c0ffee5c0ffee00 (4 players)
+//
+// Seats roll in Round Robin order from seat 0 and each draws from its own
+// dice stream, exactly as the server does, so the output matches game.log
+// for a game in which nobody disconnected.
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " -s game seed -p players\n"
+              << "       " << prog << " -m master seed -t table -g game -p players\n";
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t game_seed = 0, master_seed = 0;
+    bool have_game_seed = false, have_master = false;
+    int table_id = 0;
+    uint64_t game = 0;
+    int num_players = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:m:t:g:p:")) != -1) {
+        switch (opt) {
+        case 's': game_seed = strtoull(optarg, nullptr, 0); have_game_seed = true; break;
+        case 'm': master_seed = strtoull(optarg, nullptr, 0); have_master = true; break;
+        case 't': table_id = atoi(optarg); break;
+        case 'g': game = strtoull(optarg, nullptr, 0); break;
+        case 'p': num_players = atoi(optarg); break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+
+    if (have_game_seed == have_master || num_players < 1 || num_players > MAX_PLAYERS) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (have_master) game_seed = dice_game_seed(master_seed, table_id, game);
+
+    DiceRng dice[MAX_PLAYERS];
+    int positions[MAX_PLAYERS] = {};
+    for (int i = 0; i < num_players; i++) dice_seed(&dice[i], game_seed, i);
+
+    std::cout << "Game seed 0x" << std::hex << game_seed << std::dec
+              << ", " << num_players << " players\n";
+
+    for (int turn = 1, player = 0; ; turn++, player = race_next_seat(player, num_players)) {
+        int roll = dice_roll(&dice[player]);
+        positions[player] = race_advance(positions[player], roll);
+        std::cout << "Turn " << turn << ": Player " << player << " rolled " << roll
+                  << " (position=" << positions[player] << ")\n";
+
+        if (race_won(positions[player], WIN_POSITION)) {
+            std::cout << "Player " << player << " WON after " << turn << " turns\n";
+            break;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,204 @@
+#ifndef SCORE_STORE_HPP
+#define SCORE_STORE_HPP
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <unordered_map>
+
+#include "common.hpp"
+
+// ---- Score store ----
+// Wins per player name, kept durable as a snapshot plus an append-only
+// journal:
+//
+//   scores.txt      "# race-scores v2 seq=<n>" then "<name> <wins>" lines
+//   scores.journal  one "<seq> <name>" line per win, fdatasync'd per batch
+//
+// Recovery loads the snapshot and replays journal records with a higher
+// sequence number, stopping at the first torn or malformed line. A
+// snapshot is written to a temporary file, fsync'd and renamed over the
+// old one before the journal is truncated, so a crash at any point leaves
+// either the old or the new snapshot plus a journal that covers the gap.
+constexpr const char* SCORE_SNAPSHOT_PATH = "scores.txt";
+constexpr const char* SCORE_JOURNAL_PATH = "scores.journal";
+constexpr const char* SCORE_SNAPSHOT_HEADER = "# race-scores v2 seq=%llu\n";
+constexpr long long SCORE_COMPACT_EVERY = 4096;   // journal records per snapshot
+
+struct ScoreStore {
+    std::unordered_map<std::string, long long> wins;
+    unsigned long long seq = 0;          // last win applied
+    int journal_fd = -1;
+    off_t journal_size = 0;              // bytes known to be intact
+    long long journal_records = 0;       // records since the last snapshot
+};
+
+// Names go into space-separated text records
+inline bool score_name_valid(const char* name) {
+    if (!name[0]) return false;
+    for (const char* c = name; *c; c++) {
+        if (c - name >= MAX_NAME_LEN - 1) return false;
+        if (*c <= ' ' || *c > '~' || *c == '#') return false;
+    }
+    return true;
+}
+
+// Seats that never sent a name score under this one, which is also what
+// the legacy per-seat "Table<t> Player<p> <wins>" lines migrate to
+inline std::string default_player_name(int table_id, int player_id) {
+    return "table" + std::to_string(table_id) + "_player" + std::to_string(player_id);
+}
+
+// Load the snapshot. Returns its sequence number (0 for a legacy file).
+inline unsigned long long score_load_snapshot(ScoreStore* store, const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) return 0;
+
+    unsigned long long snapshot_seq = 0;
+    bool versioned = false;
+    char line[128];
+    char name[MAX_NAME_LEN];
+
+    while (fgets(line, sizeof(line), f)) {
+        int table_id = 0, id;
+        long long count;
+
+        if (sscanf(line, SCORE_SNAPSHOT_HEADER, &snapshot_seq) == 1) {
+            versioned = true;
+        } else if (versioned) {
+            if (sscanf(line, "%31s %lld", name, &count) == 2 && score_name_valid(name))
+                store->wins[name] = count;
+        } else if (sscanf(line, "Table%d Player%d %lld", &table_id, &id, &count) == 3 ||
+                   sscanf(line, "Player%d %lld", &id, &count) == 2) {
+            if (count > 0) store->wins[default_player_name(table_id, id)] += count;
+        }
+    }
+
+    fclose(f);
+    return snapshot_seq;
+}
+
+// Apply journal records newer than the snapshot. Returns the number applied.
+inline long long score_replay_journal(ScoreStore* store, const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) return 0;
+
+    long long applied = 0;
+    char line[128];
+    char name[MAX_NAME_LEN];
+
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long long seq;
+        size_t len = strlen(line);
+        if (len == 0 || line[len - 1] != '\n') break;      // torn tail
+        if (sscanf(line, "%llu %31s", &seq, name) != 2 || !score_name_valid(name)) break;
+        if (seq <= store->seq) continue;                    // already in the snapshot
+
+        store->wins[name]++;
+        store->seq = seq;
+        applied++;
+    }
+
+    fclose(f);
+    return applied;
+}
+
+// fsync the directory entry after a rename
+inline void score_sync_dir(const char* path) {
+    std::string dir = path;
+    size_t slash = dir.rfind('/');
+    dir = (slash == std::string::npos) ? "." : dir.substr(0, slash);
+
+    int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) return;
+    fsync(fd);
+    close(fd);
+}
+
+// Write a snapshot of every total and empty the journal
+inline bool score_store_compact(ScoreStore* store) {
+    std::string tmp = std::string(SCORE_SNAPSHOT_PATH) + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "w");
+    if (!f) {
+        perror("scores snapshot");
+        return false;
+    }
+
+    fprintf(f, SCORE_SNAPSHOT_HEADER, store->seq);
+    for (const auto& entry : store->wins)
+        fprintf(f, "%s %lld\n", entry.first.c_str(), entry.second);
+
+    bool ok = fflush(f) == 0 && fsync(fileno(f)) == 0;
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmp.c_str(), SCORE_SNAPSHOT_PATH) < 0) {
+        perror("scores snapshot");
+        unlink(tmp.c_str());
+        return false;
+    }
+    score_sync_dir(SCORE_SNAPSHOT_PATH);
+
+    // The snapshot covers every record, so the journal can start over
+    if (ftruncate(store->journal_fd, 0) == 0) {
+        store->journal_size = 0;
+        store->journal_records = 0;
+    }
+    return true;
+}
+
+// Recover from snapshot + journal, then compact so the journal starts
+// empty (this also drops a torn tail left by a crash).
+inline bool score_store_open(ScoreStore* store) {
+    store->seq = score_load_snapshot(store, SCORE_SNAPSHOT_PATH);
+    long long replayed = score_replay_journal(store, SCORE_JOURNAL_PATH);
+
+    store->journal_fd = open(SCORE_JOURNAL_PATH, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (store->journal_fd < 0) {
+        perror("open scores.journal");
+        return false;
+    }
+
+    if (replayed > 0)
+        std::cout << "[SERVER] Replayed " << replayed << " win(s) from scores.journal\n";
+    return score_store_compact(store);
+}
+
+// Group commit: append one record per win with a single write() and a
+// single fdatasync(), then apply them. On failure the journal is cut back
+// to its last intact length and nothing is applied.
+inline bool score_store_append(ScoreStore* store, const ScoreEvent* events, int count) {
+    std::string batch;
+    batch.reserve(count * 24);
+
+    char record[64];
+    for (int i = 0; i < count; i++) {
+        int len = snprintf(record, sizeof(record), "%llu %s\n",
+                           store->seq + 1 + i, events[i].name);
+        batch.append(record, len);
+    }
+
+    size_t written = 0;
+    while (written < batch.size()) {
+        ssize_t n = write(store->journal_fd, batch.data() + written, batch.size() - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        written += n;
+    }
+
+    if (written < batch.size() || fdatasync(store->journal_fd) < 0) {
+        perror("write scores.journal");
+        if (ftruncate(store->journal_fd, store->journal_size) < 0) perror("ftruncate scores.journal");
+        return false;
+    }
+
+    for (int i = 0; i < count; i++) store->wins[events[i].name]++;
+    store->seq += count;
+    store->journal_size += batch.size();
+    store->journal_records += count;
+    return true;
+}
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef SEAT_MASK_HPP
+#define SEAT_MASK_HPP
+
+#include <cstdint>
+
+// ---- Seat mask ----
+// One bit per seat of a table, N seats wide. Finding the next seat that
+// is set is a bit-scan per 64-bit word instead of a test of every seat,
+// which keeps turn order O(1) for tables of up to 64 seats and O(N / 64)
+// past that. Plain data, so it can live in shared memory (writers
+// serialize on the table's game_mutex).
+template <int N>
+struct SeatMask {
+    static_assert(N >= 1, "a table has at least one seat");
+    static constexpr int WORDS = (N + 63) / 64;
+
+    uint64_t words[WORDS];
+
+    void clear() {
+        for (int w = 0; w < WORDS; w++) words[w] = 0;
+    }
+
+    void set(int seat, bool on = true) {
+        uint64_t bit = uint64_t(1) << (seat & 63);
+        if (on) words[seat >> 6] |= bit;
+        else words[seat >> 6] &= ~bit;
+    }
+
+    bool test(int seat) const {
+        return (words[seat >> 6] >> (seat & 63)) & 1;
+    }
+
+    int count() const {
+        int total = 0;
+        for (int w = 0; w < WORDS; w++) total += __builtin_popcountll(words[w]);
+        return total;
+    }
+
+    // Lowest set seat in [from, limit), or -1
+    int find_from(int from, int limit) const {
+        if (from >= limit) return -1;
+        int w = from >> 6;
+        uint64_t bits = words[w] & (~uint64_t(0) << (from & 63));
+        while (true) {
+            if (bits) {
+                int seat = (w << 6) + __builtin_ctzll(bits);
+                return seat < limit ? seat : -1;
+            }
+            if (++w >= WORDS || (w << 6) >= limit) return -1;
+            bits = words[w];
+        }
+    }
+
+    // Round Robin over the first `limit` seats: the set seat after `seat`,
+    // wrapping to seat 0 (possibly `seat` itself). -1 if none is set.
+    int next_after(int seat, int limit) const {
+        int next = find_from(seat + 1, limit);
+        return next >= 0 ? next : find_from(0, limit);
+    }
+};
+
+#endif
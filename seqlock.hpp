@@ -0,0 +1,86 @@
+#ifndef SEQLOCK_HPP
+#define SEQLOCK_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <type_traits>
+#include <unistd.h>
+
+// ---- Sequence lock ----
+// Writers (already serialized by their own mutex) make the counter odd
+// while they change the protected data and even again when done. Readers
+// never block a writer: they copy the data and retry if the counter was
+// odd or moved during the copy. Works across processes in shared memory.
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "seqlock needs address-free atomics to work across processes");
+
+inline void seq_write_begin(std::atomic<uint32_t>* seq) {
+    seq->store(seq->load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+inline void seq_write_end(std::atomic<uint32_t>* seq) {
+    seq->store(seq->load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+// For writers that no mutex serializes: take the write side unless
+// another writer has it. Returns false, changing nothing, if one does.
+inline bool seq_try_write_begin(std::atomic<uint32_t>* seq) {
+    uint32_t start = seq->load(std::memory_order_relaxed);
+    if ((start & 1) || !seq->compare_exchange_strong(start, start + 1, std::memory_order_relaxed))
+        return false;
+    std::atomic_thread_fence(std::memory_order_release);
+    return true;
+}
+
+// Copy `src` word by word with relaxed atomic loads, so a copy that races
+// a writer is discarded by the retry instead of being undefined behaviour.
+template <typename T>
+inline void seq_copy(T* dst, const T* src) {
+    static_assert(std::is_trivially_copyable<T>::value && sizeof(T) % sizeof(uint32_t) == 0 &&
+                  alignof(T) >= alignof(uint32_t), "seq_copy needs a POD of 32-bit words");
+
+    const uint32_t* from = reinterpret_cast<const uint32_t*>(src);
+    uint32_t* to = reinterpret_cast<uint32_t*>(dst);
+    for (size_t i = 0; i < sizeof(T) / sizeof(uint32_t); i++)
+        to[i] = __atomic_load_n(&from[i], __ATOMIC_RELAXED);
+}
+
+// Consistent copy of `src`. Returns the (even) sequence it was taken at,
+// which doubles as a version: it only changes when the data does.
+template <typename T>
+inline uint32_t seq_read(const std::atomic<uint32_t>* seq, T* dst, const T* src) {
+    while (true) {
+        uint32_t start = seq->load(std::memory_order_acquire);
+        if (start & 1) {
+            sched_yield();   // writer mid-update (maybe preempted), let it finish
+            continue;
+        }
+
+        seq_copy(dst, src);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq->load(std::memory_order_relaxed) == start) return start;
+    }
+}
+
+// Block while the sequence is still `version` (or until timeout_ms passes).
+// The futex is shared, not private, so a reader in another process works
+// on a read-only mapping of the segment.
+inline void seq_wait(const std::atomic<uint32_t>* seq, uint32_t version, int timeout_ms) {
+    timespec timeout = { timeout_ms / 1000, (timeout_ms % 1000) * 1000000L };
+    syscall(SYS_futex, reinterpret_cast<const uint32_t*>(seq), FUTEX_WAIT, version,
+            &timeout, nullptr, 0);
+}
+
+// Wake every reader blocked in seq_wait(); one syscall however many wait
+inline void seq_wake(std::atomic<uint32_t>* seq) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(seq), FUTEX_WAKE, INT_MAX,
+            nullptr, nullptr, 0);
+}
+
+#endif
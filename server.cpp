@@ -1,534 +1,3076 @@
-#include <iostream>
-#include <fcntl.h>
-#include <sys/mman.h>
-#include <sys/stat.h>
-#include <unistd.h>
-#include <csignal>
-#include <sys/wait.h>
-#include <cstdlib>
-#include <cstring>
-#include <pthread.h>
-#include <ctime>
-#include <sstream>
-#include <iomanip>
-#include <string>
-#include <algorithm>
-#include <vector>
-
-#include "common.hpp"
-
-constexpr const char* SHM_NAME = "/race_game_shm";
-
-void load_scores(SharedData* shared);
-void save_scores(SharedData* shared);
-void reset_game(SharedData* shared);
-
-// ========================================
-// Global pointer for signal handler
-// ========================================
-SharedData* g_shared = nullptr;
-
-/* ========================================
-   SIGNAL HANDLER - Reap Zombie Processes
-   ======================================== */
-void sigchld_handler(int) {
-    while (waitpid(-1, nullptr, WNOHANG) > 0);
-}
-
-// ========================================
-// SIGINT Handler for graceful shutdown
-// ========================================
-void sigint_handler(int) {
-    std::cout << "\n[SERVER] Received SIGINT. Shutting down gracefully...\n";
-    
-    if (g_shared) {
-        save_scores(g_shared);
-        
-        // Cleanup shared memory
-        munmap(g_shared, sizeof(SharedData));
-        shm_unlink(SHM_NAME);
-        
-        std::cout << "[SERVER] Cleanup complete. Goodbye!\n";
-    }
-    
-    exit(0);
-}
-
-/* ========================================
-   LOGGER THREAD - Concurrent Log Writing
-   ======================================== */
-void* logger_thread(void* arg) {
-    SharedData* shared = static_cast<SharedData*>(arg);
-    FILE* log = fopen("game.log", "a");
-
-    if (!log) {
-        perror("fopen game.log");
-        return nullptr;
-    }
-
-    std::cout << "[SERVER] Logger thread started\n";
-
-    while (true) {
-        pthread_mutex_lock(&shared->log_mutex);
-
-        if (shared->log_pending) {
-            fprintf(log, "%s\n", shared->log_buffer);
-            fflush(log);
-            shared->log_pending = 0;
-        }
-
-        pthread_mutex_unlock(&shared->log_mutex);
-        usleep(100000); // 100ms
-    }
-
-    fclose(log);
-    return nullptr;
-}
-
-/* ========================================
-   SCHEDULER THREAD - Round Robin Turn Management
-   ======================================== */
-void* scheduler_thread(void* arg) {
-    SharedData* shared = static_cast<SharedData*>(arg);
-    
-    std::cout << "[SERVER] Scheduler thread started\n";
-
-    while (true) {
-        pthread_mutex_lock(&shared->game_mutex);
-
-        // Only manage turns when game is active
-        if (shared->game.game_active && !shared->game.game_over && shared->game.turn_complete) {
-            
-            // Advance to next player (Round Robin)
-            int next_turn = (shared->game.current_turn + 1) % shared->game.num_players;
-            
-            // Skip disconnected players
-            int attempts = 0;
-            while (!shared->players[next_turn].connected && attempts < shared->game.num_players) {
-                next_turn = (next_turn + 1) % shared->game.num_players;
-                attempts++;
-            }
-
-            // Update turn
-            shared->game.current_turn = next_turn;
-            shared->game.turn_complete = 0;  // Reset flag for next turn
-
-            // Log turn change
-            pthread_mutex_lock(&shared->log_mutex);
-            snprintf(shared->log_buffer, sizeof(shared->log_buffer),
-                     "[SCHEDULER] Turn advanced to Player %d", next_turn);
-            shared->log_pending = 1;
-            pthread_mutex_unlock(&shared->log_mutex);
-
-            std::cout << "[SCHEDULER] Turn -> Player " << next_turn << "\n";
-        }
-
-        pthread_mutex_unlock(&shared->game_mutex);
-        usleep(50000); // Check every 50ms
-    }
-
-    return nullptr;
-}
-
-/* ========================================
-   PERSISTENT SCORING
-   ======================================== */
-void load_scores(SharedData* shared) {
-    pthread_mutex_lock(&shared->score_mutex);
-
-    // Initialize default scores
-    for (int i = 0; i < MAX_PLAYERS; i++)
-        shared->scores[i] = 0;
-
-    FILE* f = fopen("scores.txt", "r");
-    if (!f) {
-        pthread_mutex_unlock(&shared->score_mutex);
-        std::cout << "[SERVER] No existing scores.txt, starting fresh\n";
-        return;
-    }
-
-    int id, score;
-    while (fscanf(f, "Player%d %d", &id, &score) == 2) {
-        if (id >= 0 && id < MAX_PLAYERS)
-            shared->scores[id] = score;
-    }
-
-    fclose(f);
-    pthread_mutex_unlock(&shared->score_mutex);
-    std::cout << "[SERVER] Scores loaded from scores.txt\n";
-}
-
-void save_scores(SharedData* shared) {
-    pthread_mutex_lock(&shared->score_mutex);
-
-    FILE* f = fopen("scores.txt", "w");
-    if (!f) {
-        perror("scores.txt");
-        pthread_mutex_unlock(&shared->score_mutex);
-        return;
-    }
-
-    for (int i = 0; i < MAX_PLAYERS; i++) {
-        fprintf(f, "Player%d %d\n", i, shared->scores[i]);
-    }
-
-    fclose(f);
-    pthread_mutex_unlock(&shared->score_mutex);
-    std::cout << "[SERVER] Scores saved to scores.txt\n";
-}
-
-/* ========================================
-   GAME RESET - Multi-Game Support
-   ======================================== */
-void reset_game(SharedData* shared) {
-    pthread_mutex_lock(&shared->game_mutex);
-
-    std::cout << "[SERVER] Resetting game state for new game...\n";
-
-    for (int i = 0; i < MAX_PLAYERS; i++) {
-        shared->game.positions[i] = 0;
-    }
-
-    shared->game.current_turn = 0;
-    shared->game.winner = -1;
-    shared->game.game_over = 0;
-    shared->game.game_active = 1;
-    shared->game.turn_complete = 0;
-
-    pthread_mutex_unlock(&shared->game_mutex);
-
-    // Log reset
-    pthread_mutex_lock(&shared->log_mutex);
-    snprintf(shared->log_buffer, sizeof(shared->log_buffer),
-             "========== NEW GAME STARTED ==========");
-    shared->log_pending = 1;
-    pthread_mutex_unlock(&shared->log_mutex);
-}
-
-void print_leaderboard(int positions[], int num_players)
-{
-    std::vector<std::pair<int, int>> leaderboard;
-    for (int i = 0; i < num_players;++i)
-    {
-        leaderboard.emplace_back(i, positions[i]);
-    }
-
-    std::sort(leaderboard.begin(), leaderboard.end(), [](const auto& a, const auto& b)
-    {
-       return a.second > b.second;
-    });
-
-    std::cout << "=================================================\n";
-    std::cout << " LEADERBOARD:\n";
-
-    const char* suffixes[] = {"1st", "2nd", "3rd", "4th", "5th"};
-    for (size_t rank = 0; rank < leaderboard.size(); ++rank)
-    {
-        int player_id = leaderboard[rank].first;
-        int distance = leaderboard[rank].second;
-        std::cout << " " << suffixes[rank] << ": PLAYER " << (player_id + 1)
-                  << " (Distance: " << distance << ")\n";
-    }
-    std::cout << "==================================================\n";
-}
-
-std::string generate_race_track(int positions[], int goal=WIN_POSITION)
-{
-    std::ostringstream ss;
-
-    ss << "===============================================\n";
-    ss << " RACE TRACK (Goal: " << goal << "m)\n";
-    ss << "===============================================\n\n";
-
-    for (int p = 0; p < MAX_PLAYERS; ++p)
-    {
-        int pos = positions[p];
-        if (pos > goal) pos = goal;
-
-        ss << "P" << (p + 1) << " [" << std::setw(2) << std::setfill('0') << pos << "m]";
-        ss << "|";
-        for (int i = 0; i < pos; ++i) ss << "-";
-        ss << " -O- ";
-        for (int i = pos + 1; i < goal; ++i) ss << "-";
-        ss << "|\n";
-        ss << "        |";
-        for (int i = 0; i < pos; ++i) ss << " ";
-        ss << " | # | ";
-        for (int i = pos + 1; i < goal; ++i) ss << " ";
-        ss << "|\n";
-        ss << "        |";
-        for (int i = 0; i < pos; ++i) ss << "-";
-        ss << " -O- ";
-        for (int i = pos + 1; i < goal; ++i) ss << "-";
-        ss << "|\n\n";
-    }
-    return ss.str();
-}
-
-/* ========================================
-   MAIN SERVER
-   ======================================== */
-int main() {
-    srand(time(nullptr));
-
-    /* ---------- GET NUMBER OF PLAYERS ---------- */
-    int num_players;
-    std::cout << "Enter number of players (3-5): ";
-    std::cin >> num_players;
-    
-    if (num_players < 3 || num_players > 5) {
-        std::cerr << "Error: Must be 3-5 players\n";
-        return 1;
-    }
-
-    /* ---------- SIGNAL HANDLERS ---------- */
-    struct sigaction sa{};
-    sa.sa_handler = sigchld_handler;
-    sigemptyset(&sa.sa_mask);
-    sa.sa_flags = SA_RESTART;
-    sigaction(SIGCHLD, &sa, nullptr);
-
-    // ========================================
-    // Register SIGINT handler
-    // ========================================
-    signal(SIGINT, sigint_handler);
-
-    /* ---------- SHARED MEMORY ---------- */
-    shm_unlink(SHM_NAME);
-    int shm_fd = shm_open(SHM_NAME, O_CREAT | O_RDWR, 0666);
-    if (shm_fd < 0) {
-        perror("shm_open");
-        return 1;
-    }
-    
-    ftruncate(shm_fd, sizeof(SharedData));
-
-    SharedData* shared = static_cast<SharedData*>(
-        mmap(nullptr, sizeof(SharedData),
-             PROT_READ | PROT_WRITE,
-             MAP_SHARED, shm_fd, 0)
-    );
-
-    if (shared == MAP_FAILED) {
-        perror("mmap");
-        return 1;
-    }
-
-    std::memset(shared, 0, sizeof(SharedData));
-
-    // ========================================
-    // Set global pointer for signal handler
-    // ========================================
-    g_shared = shared;
-
-    /* ---------- PROCESS-SHARED MUTEX INIT ---------- */
-    pthread_mutexattr_t attr;
-    pthread_mutexattr_init(&attr);
-    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
-
-    pthread_mutex_init(&shared->game_mutex, &attr);
-    pthread_mutex_init(&shared->log_mutex, &attr);
-    pthread_mutex_init(&shared->score_mutex, &attr);
-
-    pthread_mutexattr_destroy(&attr);
-
-    /* ---------- INITIALIZE GAME STATE ---------- */
-    load_scores(shared);
-
-    shared->game.num_players = num_players;
-    shared->game.current_turn = 0;
-    shared->game.game_active = 0;
-    shared->game.winner = -1;
-    shared->game.game_over = 0;
-    shared->game.active_players = 0;
-    shared->game.turn_complete = 0;
-
-    /* ---------- LOGGER THREAD ---------- */
-    shared->log_pending = 0;
-
-    pthread_t logger;
-    if (pthread_create(&logger, nullptr, logger_thread, shared) != 0) {
-        perror("pthread_create logger");
-        return 1;
-    }
-
-    /* ---------- SCHEDULER THREAD ---------- */
-    pthread_t scheduler;
-    if (pthread_create(&scheduler, nullptr, scheduler_thread, shared) != 0) {
-        perror("pthread_create scheduler");
-        return 1;
-    }
-
-    /* ---------- CREATE FIFOS ---------- */
-    for (int i = 0; i < MAX_PLAYERS; i++) {
-        std::string in_fifo  = "/tmp/player_" + std::to_string(i) + "_in";
-        std::string out_fifo = "/tmp/player_" + std::to_string(i) + "_out";
-        unlink(in_fifo.c_str());
-        unlink(out_fifo.c_str());
-        mkfifo(in_fifo.c_str(), 0666);
-        mkfifo(out_fifo.c_str(), 0666);
-    }
-
-    std::cout << "[SERVER] Waiting for " << num_players << " players...\n";
-
-    /* ---------- FORK PLAYER PROCESSES ---------- */
-    for (int player_id = 0; player_id < num_players; player_id++) {
-        pid_t pid = fork();
-
-        if (pid < 0) {
-            perror("fork");
-            return 1;
-        }
-
-        if (pid == 0) {
-            /* ===== CHILD PROCESS (Player Handler) ===== */
-
-            std::string in_fifo  = "/tmp/player_" + std::to_string(player_id) + "_in";
-            std::string out_fifo = "/tmp/player_" + std::to_string(player_id) + "_out";
-
-            int fd_in  = open(in_fifo.c_str(), O_RDWR);
-            int fd_out = open(out_fifo.c_str(), O_RDWR);
-
-            if (fd_in < 0 || fd_out < 0) {
-                perror("FIFO open in child");
-                exit(1);
-            }
-
-            // Mark player as connected
-            pthread_mutex_lock(&shared->game_mutex);
-            shared->players[player_id].connected = 1;
-            shared->game.active_players++;
-
-            // Start game when all players connected
-            if (shared->game.active_players == num_players) {
-                shared->game.game_active = 1;
-                shared->game.current_turn = 0;
-                shared->game.turn_complete = 0;
-                
-                pthread_mutex_lock(&shared->log_mutex);
-                snprintf(shared->log_buffer, sizeof(shared->log_buffer),
-                        "========== GAME STARTED: %d PLAYERS ==========", num_players);
-                shared->log_pending = 1;
-                pthread_mutex_unlock(&shared->log_mutex);
-
-                std::cout << "[SERVER] All " << num_players << " players connected. Game started!\n";
-            }
-
-            pthread_mutex_unlock(&shared->game_mutex);
-
-            char buffer[64];
-
-            // Player event loop
-            while (true) {
-                pthread_mutex_lock(&shared->game_mutex);
-
-                // Handle game over
-                if (shared->game.game_over) {
-                    pthread_mutex_unlock(&shared->game_mutex);
-                    sleep(3); // Pause between games
-                    reset_game(shared);
-                    continue;
-                }
-
-                // Wait for my turn
-                if (!shared->game.game_active ||
-                    shared->game.current_turn != player_id ||
-                    shared->game.turn_complete) {
-                    pthread_mutex_unlock(&shared->game_mutex);
-                    usleep(100000);
-                    continue;
-                }
-
-                // It's my turn!
-                write(fd_out, "YOUR_TURN\n", 10);
-                pthread_mutex_unlock(&shared->game_mutex);
-
-                // Wait for player action
-                std::memset(buffer, 0, sizeof(buffer));
-                ssize_t bytes = read(fd_in, buffer, sizeof(buffer));
-                if (bytes <= 0) {
-                    // Player disconnected
-                    pthread_mutex_lock(&shared->game_mutex);
-                    shared->players[player_id].connected = 0;
-                    pthread_mutex_unlock(&shared->game_mutex);
-                    break;
-                }
-
-                // Roll dice (server-side randomness)
-                int dice = (rand() % 6) + 1;
-
-                pthread_mutex_lock(&shared->game_mutex);
-                if(!shared->game.game_over) {
-                    shared->game.positions[player_id] += dice;
-                    print_leaderboard(shared->game.positions, MAX_PLAYERS); }
-
-                pthread_mutex_unlock(&shared->game_mutex);
-
-                std::string display = generate_race_track(shared->game.positions);
-                for (int i = 0; i < MAX_PLAYERS; i++)
-                {
-                    std::string out_fifo = "/tmp/player_" + std::to_string(i) + "_out";
-                    int fd = open(out_fifo.c_str(), O_WRONLY | O_NONBLOCK);
-                    if (fd >= 0)
-                    {
-                        write(fd, display.c_str(), display.size());
-                        close(fd);
-                    }
-                }
-
-                std::cout << "[SERVER] Player " << player_id
-                          << " rolled " << dice
-                          << " -> position " << shared->game.positions[player_id] << "\n";
-
-                pthread_mutex_lock(&shared->log_mutex);
-                snprintf(shared->log_buffer, sizeof(shared->log_buffer),
-                         "Player %d rolled %d (position=%d)",
-                         player_id, dice, shared->game.positions[player_id]);
-                shared->log_pending = 1;
-                pthread_mutex_unlock(&shared->log_mutex);
-
-                // Check win condition
-                if (shared->game.positions[player_id] >= WIN_POSITION) {
-                    shared->game.winner = player_id;
-
-                    // Update score atomically
-                    pthread_mutex_lock(&shared->score_mutex);
-                    shared->scores[player_id]++;
-                    pthread_mutex_unlock(&shared->score_mutex);
-
-                    // Log win
-                    pthread_mutex_lock(&shared->log_mutex);
-                    snprintf(shared->log_buffer, sizeof(shared->log_buffer),
-                             "Player %d WON! Total wins = %d",
-                             player_id, shared->scores[player_id]);
-                    shared->log_pending = 1;
-                    pthread_mutex_unlock(&shared->log_mutex);
-
-                    save_scores(shared);
-
-                    write(fd_out, "YOU_WIN\n", 8);
-                    std::cout << "[SERVER] Player " << player_id << " WINS!\n";
-
-                    shared->game.game_active = 0;
-                    shared->game.game_over = 1;
-                }
-
-                // Signal turn complete (scheduler will advance turn)
-                shared->game.turn_complete = 1;
-
-                pthread_mutex_unlock(&shared->game_mutex);
-            }
-
-            close(fd_in);
-            close(fd_out);
-            exit(0);
-        }
-    }
-
-    /* ---------- PARENT WAITS ---------- */
-    std::cout << "[SERVER] All player processes forked. Running...\n";
-    std::cout << "[SERVER] Press Ctrl+C to shutdown gracefully\n";
-    while (true) pause();
-
-    return 0;
-}
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <csignal>
+#include <sys/wait.h>
+#include <sys/uio.h>
+#include <climits>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <pthread.h>
+#include <ctime>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <algorithm>
+#include <vector>
+#include <deque>
+#include <random>
+#include <atomic>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unordered_map>
+
+#include "common.hpp"
+#include "broadcast.hpp"
+#include "protocol.hpp"
+#include "race_rules.hpp"
+#include "race_track.hpp"
+#include "metrics.hpp"
+#include "score_store.hpp"
+#include "trace.hpp"
+
+void submit_win(SharedData* shared, Table* table, const char* name);
+int commit_score_events(SharedData* shared);
+void reset_game(SharedData* shared, Table* table);
+int release_empty_seats(Table* table);
+
+// ========================================
+// Global pointer for signal handler
+// ========================================
+SharedData* g_shared = nullptr;
+pid_t g_server_pid = 0;
+int g_log_fd = -1;
+
+// Table segment: mapped once for MAX_TABLES before any fork, so every
+// process sees tables at the same address as the segment grows.
+Table* g_tables = nullptr;
+int g_tables_fd = -1;
+
+// Live metrics segment, read by the stats tool
+MetricsBlock* g_metrics = nullptr;
+
+// Span buffers (-T, see trace.hpp), merged into this file on shutdown and
+// whenever SIGUSR1 asks for it
+std::string g_trace_path;
+volatile sig_atomic_t g_trace_requested = 0;
+
+// Durable wins per player name. Only the parent process touches it
+// (scorekeeper thread and shutdown), under score_mutex.
+ScoreStore g_scores;
+
+// Render stage: every handler process, reactor and the spectator thread
+// draws frames into its own buffer from a snapshot, never under game_mutex
+thread_local RaceTrack<WIN_POSITION> t_track;
+thread_local char t_frame[STATE_FRAME_MAX];   // copy of Table::frame, see copy_state_frame()
+
+int flush_log_ring(SharedData* shared, int fd);
+int flush_event_queue(SharedData* shared);
+
+// Binary event log (events-*.bin), written by the logger thread and, at
+// shutdown, under log_mutex by the main thread
+EventLog g_events;
+
+// Workers to stop for a warm restart (SIGTERM): the pid of each seat's
+// handler (fork mode) and the reactor threads
+struct Reactor;
+std::vector<pid_t>* g_handlers = nullptr;
+std::vector<Reactor>* g_reactors = nullptr;
+std::atomic<bool> g_stopping{false};
+void stop_workers();
+
+/* ========================================
+   SIGNAL HANDLER - Child Exits
+   ======================================== */
+// Only interrupts the parent's sigsuspend(); reap_handlers() does the
+// reaping, so it can see which seat's handler exited and how.
+void sigchld_handler(int) {
+}
+
+// SIGUSR1: the main thread writes the trace once it is back from sigsuspend()
+void sigusr1_handler(int) {
+    g_trace_requested = 1;
+}
+
+// Merge the span buffers into g_trace_path (tracing on only)
+void write_trace() {
+    if (!g_trace) return;
+    long spans = trace_write(g_trace, g_trace_path.c_str());
+    if (spans >= 0)
+        std::cout << "[SERVER] Trace: " << spans << " spans written to " << g_trace_path << "\n";
+}
+
+// Summary on the console, then queued wins and log lines written out.
+// Runs on every shutdown, also when stopping for a warm restart.
+void shutdown_flush() {
+    long long handoff_total = 0, handoff_max = 0;
+    long long handoff_count = 0;
+    for (int t = 0; t < g_shared->num_tables; t++) {
+        handoff_total += g_tables[t].handoff_total_ns;
+        handoff_count += g_tables[t].handoff_count;
+        handoff_max = std::max(handoff_max, g_tables[t].handoff_max_ns);
+    }
+    if (handoff_count > 0) {
+        std::cout << "[SERVER] Turn handoff latency: avg "
+                  << (handoff_total / handoff_count) / 1000
+                  << " us, max " << handoff_max / 1000
+                  << " us over " << handoff_count << " turns\n";
+    }
+
+    BroadcastStats bc{};
+    for (int t = 0; t < g_shared->num_tables; t++) {
+        bc.broadcasts += g_tables[t].broadcast.broadcasts;
+        bc.syscalls += g_tables[t].broadcast.syscalls;
+        bc.bytes += g_tables[t].broadcast.bytes;
+        bc.drops += g_tables[t].broadcast.drops;
+        bc.wakes += g_tables[t].broadcast.wakes;
+    }
+    if (bc.broadcasts > 0) {
+        std::cout << "[SERVER] Broadcasts: " << bc.broadcasts << " frames, "
+                  << std::fixed << std::setprecision(1)
+                  << static_cast<double>(bc.syscalls) / bc.broadcasts
+                  << " write syscalls and " << bc.bytes / bc.broadcasts
+                  << " bytes per broadcast, " << bc.drops << " found a full FIFO\n";
+    }
+    if (bc.wakes > 0)
+        std::cout << "[SERVER] Shared-memory viewers: " << bc.wakes << " futex wakes\n";
+
+    // Journal wins still queued, then fold everything into the snapshot
+    metrics_lock(&g_shared->score_mutex, &t_metrics->score_mutex_wait);
+    commit_score_events(g_shared);
+    if (score_store_compact(&g_scores))
+        std::cout << "[SERVER] Scores saved to " << SCORE_SNAPSHOT_PATH << "\n";
+    pthread_mutex_unlock(&g_shared->score_mutex);
+
+    // Write out anything still queued for the logger
+    if (g_log_fd >= 0) {
+        metrics_lock(&g_shared->log_mutex, &t_metrics->log_mutex_wait);
+        flush_log_ring(g_shared, g_log_fd);
+        flush_event_queue(g_shared);
+        pthread_mutex_unlock(&g_shared->log_mutex);
+    }
+
+    unsigned dropped = g_shared->log_ring.dropped.load();
+    if (dropped > 0)
+        std::cout << "[SERVER] Log entries dropped: " << dropped << "\n";
+
+    write_trace();
+}
+
+// ========================================
+// SIGINT Handler for graceful shutdown
+// ========================================
+void sigint_handler(int) {
+    // Forked player handlers inherit this handler; only the parent cleans up
+    if (getpid() != g_server_pid) _exit(0);
+
+    std::cout << "\n[SERVER] Received SIGINT. Shutting down gracefully...\n";
+
+    if (g_shared) {
+        shutdown_flush();
+
+        // Cleanup shared memory. The mappings stay until exit: the logger
+        // and scheduler threads are still blocked on semaphores inside them.
+        shm_unlink(TABLES_SHM_NAME);
+        shm_unlink(METRICS_SHM_NAME);
+        shm_unlink(TRACE_SHM_NAME);
+        shm_unlink(SHM_NAME);
+        unlink(SPECTATOR_SOCKET);
+        unlink(PLAYER_SOCKET);
+
+        std::cout << "[SERVER] Cleanup complete. Goodbye!\n";
+    }
+
+    exit(0);
+}
+
+// ========================================
+// SIGTERM Handler: stop for a warm restart
+// ========================================
+// Handlers and reactors stop where no roll is half done; shared memory and
+// FIFOs stay for the next server to resume from (server -R).
+void sigterm_handler(int) {
+    // Handlers only take SIGTERM while they wait, holding nothing
+    if (getpid() != g_server_pid) _exit(0);
+
+    std::cout << "\n[SERVER] Received SIGTERM. Stopping for warm restart...\n";
+
+    if (g_shared) {
+        stop_workers();
+        shutdown_flush();
+        g_shared->server_pid = 0;
+        std::cout << "[SERVER] Game state kept in shared memory. Resume with: ./server -R\n";
+    }
+
+    exit(0);
+}
+
+/* ========================================
+   LOGGER THREAD - Concurrent Log Writing
+   ======================================== */
+
+// Drain everything currently published in the log ring to game.log and
+// report new drops. Caller holds log_mutex. Returns the number of entries written.
+int flush_log_ring(SharedData* shared, int fd) {
+    static unsigned reported_drops = 0;
+    LogRing* ring = &shared->log_ring;
+    int total = log_ring_drain(ring, fd);
+
+    unsigned dropped = ring->dropped.load(std::memory_order_relaxed);
+    if (dropped != reported_drops) {
+        dprintf(fd, "[LOGGER] %u entries dropped (ring full)\n", dropped - reported_drops);
+        reported_drops = dropped;
+    }
+
+    return total;
+}
+
+// Queue a game event for events-*.bin. Never blocks: with the queue full
+// the record is dropped and counted.
+void log_event(SharedData* shared, const Table* table, uint64_t game_number, EventType type,
+               int seat, int arg = 0, int value = 0) {
+    EventRecord record{};
+    record.time_ns = realtime_ns();
+    record.table = table->id;
+    record.game = static_cast<uint32_t>(game_number);
+    record.type = type;
+    record.arg = static_cast<uint8_t>(arg);
+    record.seat = static_cast<uint16_t>(seat);
+    record.value = value;
+
+    if (!shared->event_queue.push(record)) {
+        metric_add(&t_metrics->events_dropped);
+        return;
+    }
+    sem_post(&shared->log_ring.wakeup);
+}
+
+// Number and append every queued event. Caller holds log_mutex.
+// Returns the number of records written.
+int flush_event_queue(SharedData* shared) {
+    constexpr int BATCH = 512;
+    EventRecord batch[BATCH];
+    int total = 0;
+
+    while (true) {
+        int count = 0;
+        while (count < BATCH && shared->event_queue.pop(batch[count])) count++;
+        if (count == 0) break;
+
+        int written = event_log_append(&g_events, batch, count);
+        if (written < count) metric_add(&t_metrics->events_dropped, count - written);
+        total += written;
+    }
+    return total;
+}
+
+void* logger_thread(void* arg) {
+    SharedData* shared = static_cast<SharedData*>(arg);
+    int log = open("game.log", O_WRONLY | O_CREAT | O_APPEND, 0644);
+
+    if (log < 0) {
+        perror("open game.log");
+        return nullptr;
+    }
+    g_log_fd = log;
+
+    metrics_attach(g_metrics, "logger");
+    trace_attach("logger");
+    metrics_lock(&shared->log_mutex, &t_metrics->log_mutex_wait);
+    bool events = event_log_open(&g_events, ".");
+    pthread_mutex_unlock(&shared->log_mutex);
+    if (events)
+        std::cout << "[SERVER] Event log: " << event_segment_path(".", g_events.segment)
+                  << " from seq " << g_events.next_seq << "\n";
+    std::cout << "[SERVER] Logger thread started\n";
+
+    while (true) {
+        // Sleep until a producer publishes an entry
+        if (sem_wait(&shared->log_ring.wakeup) < 0) continue;
+
+        unsigned depth = shared->log_ring.head.load(std::memory_order_relaxed) -
+                         shared->log_ring.tail;
+        metric_set(&t_metrics->log_depth, depth);
+        if (depth > t_metrics->log_depth_max) metric_set(&t_metrics->log_depth_max, depth);
+
+        // Every absorbed post is followed by another drain, so no entry
+        // is left behind when we go back to sleep.
+        do {
+            long long start = trace_begin();
+            metrics_lock(&shared->log_mutex, &t_metrics->log_mutex_wait);
+            int written = flush_log_ring(shared, log);
+            int records = flush_event_queue(shared);
+            pthread_mutex_unlock(&shared->log_mutex);
+            if (written + records > 0) trace_end(TR_LOG_FLUSH, start, -1, -1, written + records);
+
+            metric_add(&t_metrics->log_written, written);
+            metric_add(&t_metrics->log_batches);
+            metric_add(&t_metrics->events_written, records);
+        } while (sem_trywait(&shared->log_ring.wakeup) == 0);
+
+        metric_set(&t_metrics->log_dropped, shared->log_ring.dropped.load());
+        metric_set(&t_metrics->event_segment, g_events.segment);
+    }
+
+    close(log);
+    return nullptr;
+}
+
+/* ========================================
+   TABLE MANAGER - Independent Game Shards
+   ======================================== */
+// Robust: if a process dies holding the mutex, the next locker gets
+// EOWNERDEAD instead of blocking forever
+void init_shared_mutex(pthread_mutex_t* mutex) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+Table* get_table(int table_id) {
+    return &g_tables[table_id];
+}
+
+// game_mutex was taken over from a handler that died holding it: the
+// state it guards may be half-written. Bring it back to something every
+// rule accepts, then mark the mutex usable again.
+void repair_table(Table* table) {
+    GameState& game = table->game;
+
+    // A write cut short leaves the seqlock odd and every reader spinning
+    bool torn = table->state_seq.load(std::memory_order_relaxed) & 1;
+    if (!torn) state_write_begin(table);
+
+    int connected = 0, watchers = 0, at_goal = -1;
+    table->seats_connected.clear();
+    for (int i = 0; i < game.num_players; i++) {
+        Player& player = table->players[i];
+        player.name[MAX_NAME_LEN - 1] = '\0';
+        set_seat_connected(table, i, player.connected != 0);
+        connected += player.connected ? 1 : 0;
+        watchers += player.shm_view ? 1 : 0;
+
+        if (game.positions[i] < 0) game.positions[i] = 0;
+        if (at_goal < 0 && race_won(game.positions[i], WIN_POSITION)) at_goal = i;
+    }
+    game.active_players = connected;
+    table->state_watchers = watchers;
+    ranking_rebuild(&table->ranking, game.positions, game.num_players);
+    if (game.current_turn < 0 || game.current_turn >= game.num_players) game.current_turn = 0;
+    game.turn_complete = game.turn_complete ? 1 : 0;
+
+    // The win is decided by the positions: finish a half-recorded one,
+    // drop a winner nobody reached the goal for
+    if (at_goal >= 0) {
+        if (game.winner < 0 || game.winner >= game.num_players ||
+            !race_won(game.positions[game.winner], WIN_POSITION))
+            game.winner = at_goal;
+        game.game_over = 1;
+        game.game_active = 0;
+    } else {
+        game.winner = -1;
+        game.game_over = 0;
+        game.game_active = game.game_active ? 1 : 0;
+    }
+    state_write_end(table);
+
+    pthread_mutex_consistent(&table->game_mutex);
+    metric_add(&t_metrics->lock_repairs);
+    log_ring_push(&g_shared->log_ring, "Table %d: game_mutex owner died, state repaired%s",
+                  table->id, torn ? " (torn write)" : "");
+    std::cout << "[SERVER] Table " << table->id << ": game_mutex owner died, state repaired\n";
+}
+
+// Take a table's game_mutex, recording the wait in the caller's metrics
+void lock_table(Table* table) {
+    long long start = trace_begin();
+    int rc = metrics_lock(&table->game_mutex, &t_metrics->game_mutex_wait);
+    trace_end(TR_LOCK_WAIT, start, table->id, -1, 0, TRACE_LOCK_MIN_NS);
+    if (rc == EOWNERDEAD) repair_table(table);
+}
+
+// Hand out the next table, growing the segment by TABLE_CHUNK if needed.
+// Only allocation takes table_mutex; play on other tables is unaffected.
+// Socket tables (dynamic) get their seats from the listener and no FIFOs.
+Table* table_create(SharedData* shared, int num_players, bool dynamic = false) {
+    pthread_mutex_lock(&shared->table_mutex);
+
+    if (shared->num_tables >= MAX_TABLES) {
+        pthread_mutex_unlock(&shared->table_mutex);
+        std::cerr << "[SERVER] Table limit reached (" << MAX_TABLES << ")\n";
+        return nullptr;
+    }
+
+    if (shared->num_tables == shared->table_capacity) {
+        int capacity = std::min(shared->table_capacity + TABLE_CHUNK, MAX_TABLES);
+        if (ftruncate(g_tables_fd, sizeof(Table) * capacity) < 0) {
+            perror("ftruncate tables");
+            pthread_mutex_unlock(&shared->table_mutex);
+            return nullptr;
+        }
+        shared->table_capacity = capacity;
+    }
+
+    Table* table = get_table(shared->num_tables);
+    table->id = shared->num_tables;
+    shared->num_tables++;
+
+    pthread_mutex_unlock(&shared->table_mutex);
+
+    // New pages are zero-filled; only the non-zero state needs setting
+    init_shared_mutex(&table->game_mutex);
+
+    table->game.num_players = num_players;
+    table->game.current_turn = 0;
+    table->game.game_active = 0;
+    table->game.winner = -1;
+    table->game.game_over = 0;
+    table->game.active_players = 0;
+    table->game.turn_complete = 0;
+    table->game.last_roll.winner = -1;
+    table->dynamic = dynamic;
+    ranking_reset(&table->ranking, num_players);
+
+    for (int i = 0; i < num_players; i++) {
+        std::string name = default_player_name(table->id, i);
+        strncpy(table->players[i].name, name.c_str(), MAX_NAME_LEN - 1);
+        if (dynamic) continue;
+
+        std::string in_fifo  = fifo_path(table->id, i, "in");
+        std::string out_fifo = fifo_path(table->id, i, "out");
+        unlink(in_fifo.c_str());
+        unlink(out_fifo.c_str());
+        mkfifo(in_fifo.c_str(), 0666);
+        mkfifo(out_fifo.c_str(), 0666);
+    }
+
+    return table;
+}
+
+/* ========================================
+   TURN LOGIC - Shared by Both Server Modes
+   ======================================== */
+
+// Outcome of one committed roll
+struct RollResult {
+    int dice;
+    int position;
+    bool won;
+    char name[MAX_NAME_LEN];      // roller's name, for the score store
+    int num_players;
+    int positions[MAX_PLAYERS];   // snapshot taken under game_mutex (num_players of them)
+    uint16_t order[MAX_PLAYERS];  // leaderboard order at the same moment
+    uint64_t game_number;         // game the roll belongs to
+    uint32_t roll_seq;            // game.last_roll.seq of the roll, 0 if it did not move
+    bool state_frames;            // some seat still reads STATE frames
+};
+void print_leaderboard(const RollResult& result);
+
+// Seed every seat's dice stream for the table's current game_number and
+// log the game seed (replay with ./replay -s <seed>). Caller holds game_mutex.
+void seed_game_dice(SharedData* shared, Table* table) {
+    table->game_seed = dice_game_seed(shared->dice_seed, table->id, table->game_number);
+    for (int i = 0; i < MAX_PLAYERS; i++) dice_seed(&table->dice[i], table->game_seed, i);
+
+    log_ring_push(&shared->log_ring, "Table %d: game %llu seed 0x%016llx (%d players)",
+                  table->id, static_cast<unsigned long long>(table->game_number),
+                  static_cast<unsigned long long>(table->game_seed), table->game.num_players);
+    log_event(shared, table, table->game_number, EV_GAME_START, 0, 0, table->game.num_players);
+}
+
+// Mark a seat as connected and start the game once every seat is in.
+// Caller holds game_mutex. Returns true if this seat started the game;
+// the caller announces it with print_game_started() once unlocked.
+bool seat_player_locked(SharedData* shared, Table* table, int player_id) {
+    // A respawned handler's seat is still connected; an idle one is taken
+    // back by the player's next input (see wake_idle_seat)
+    if (table->players[player_id].connected || table->players[player_id].idle) return false;
+    set_seat_connected(table, player_id, true);
+    state_write_begin(table);
+    table->game.active_players++;
+
+    // Start game when all players connected (a reconnect joins the running one)
+    int num_players = table->game.num_players;
+    bool start = table->game.active_players == num_players &&
+                 !table->game.game_active && !table->game.game_over;
+    if (start) {
+        table->game.game_active = 1;
+        table->game.current_turn = 0;
+        table->game.turn_complete = 0;
+    }
+    state_write_end(table);
+
+    if (start) {
+        log_ring_push(&shared->log_ring,
+                      "========== TABLE %d: GAME STARTED: %d PLAYERS ==========",
+                      table->id, num_players);
+        seed_game_dice(shared, table);
+        turn_wake(table);
+    }
+    return start;
+}
+
+void print_game_started(const Table* table) {
+    std::cout << "[SERVER] Table " << table->id << ": All " << table->game.num_players
+              << " players connected. Game started!\n";
+}
+
+void seat_player(SharedData* shared, Table* table, int player_id) {
+    lock_table(table);
+    bool started = seat_player_locked(shared, table, player_id);
+    pthread_mutex_unlock(&table->game_mutex);
+    if (started) print_game_started(table);
+}
+
+// Record how long the handoff from the previous roll took.
+// Caller holds game_mutex.
+void record_handoff(Table* table) {
+    if (table->turn_committed_ns) {
+        long long waited = monotonic_ns() - table->turn_committed_ns;
+        table->handoff_total_ns += waited;
+        table->handoff_count++;
+        if (waited > table->handoff_max_ns) table->handoff_max_ns = waited;
+        table->turn_committed_ns = 0;
+        metric_record(&t_metrics->handoff, waited);
+    }
+}
+
+// Apply a dice roll for player_id and check the win condition.
+// `auto_roll`: the server rolled because the turn deadline passed.
+RollResult commit_roll(Table* table, int player_id, int dice, bool auto_roll = false) {
+    long long start = trace_begin();
+    RollResult result{};
+    result.dice = dice;
+
+    lock_table(table);
+    if (!auto_roll) table->players[player_id].missed_turns = 0;
+    state_write_begin(table);
+    bool moved = !table->game.game_over;
+    if (moved)
+        table->game.positions[player_id] = race_advance(table->game.positions[player_id], dice);
+
+    int num_players = table->game.num_players;
+    if (moved) ranking_update(&table->ranking, table->game.positions, num_players, player_id);
+
+    result.num_players = num_players;
+    std::memcpy(result.positions, table->game.positions, num_players * sizeof(int));
+    std::memcpy(result.order, table->ranking.order, num_players * sizeof(uint16_t));
+    result.position = result.positions[player_id];
+    result.game_number = table->game_number;
+
+    // Check win condition
+    if (race_won(result.position, WIN_POSITION)) {
+        result.won = true;
+        table->game.winner = player_id;
+        table->game.game_active = 0;
+        table->game.game_over = 1;
+        std::memcpy(result.name, table->players[player_id].name, MAX_NAME_LEN);
+    }
+    if (moved) {
+        LastRoll& last = table->game.last_roll;
+        last.seq++;
+        last.player_id = player_id;
+        last.dice = dice;
+        last.position = result.position;
+        last.winner = result.won ? player_id : -1;
+        result.roll_seq = last.seq;
+    }
+    result.state_frames = table->state_watchers < num_players;
+    state_write_end(table);
+
+    // Fork mode: the other seats' handlers send their STATE frames when the
+    // scheduler wakes them for the next turn; a win has no next turn, so
+    // they are woken for the final frames now
+    if (result.won && table->players[player_id].handler_pid) turn_wake(table);
+    pthread_mutex_unlock(&table->game_mutex);
+
+    // Printed from the copy, outside the lock
+    metric_add(&t_metrics->turns);
+    if (moved) print_leaderboard(result);
+
+    trace_end(TR_COMMIT, start, table->id, player_id, dice);
+    return result;
+}
+
+// Console output, game.log entries and score saving for a committed roll.
+// The caller sends MSG_WIN to a winner.
+void announce_roll(SharedData* shared, Table* table, int player_id, const RollResult& result) {
+    long long start = trace_begin();
+    std::cout << "[SERVER] Table " << table->id << ": Player " << player_id
+              << " rolled " << result.dice
+              << " -> position " << result.position << "\n";
+
+    log_ring_push(&shared->log_ring, "Table %d: Player %d rolled %d (position=%d)",
+                  table->id, player_id, result.dice, result.position);
+    log_event(shared, table, result.game_number, EV_ROLL, player_id, result.dice,
+              result.position);
+
+    if (result.won) {
+        // Log win
+        log_ring_push(&shared->log_ring, "Table %d: Player %d (%s) WON!",
+                      table->id, player_id, result.name);
+        log_event(shared, table, result.game_number, EV_WIN, player_id, 0, result.position);
+
+        submit_win(shared, table, result.name);
+        std::cout << "[SERVER] Table " << table->id << ": Player " << player_id << " WINS!\n";
+    }
+    trace_end(TR_ANNOUNCE, start, table->id, player_id);
+}
+
+// STATE frame with the rendered track for every seat not in `skip`
+void send_state_frame(BroadcastChannel* channel, Table* table, int player_id,
+                      const RollResult& result, const SeatMask<MAX_PLAYERS>& skip) {
+    std::string_view display = t_track.render(result.positions, result.num_players);
+
+    StateFrameHead head;
+    head.hdr = make_header(MSG_STATE, sizeof(StateDelta) + display.size());
+    head.delta.player_id = player_id;
+    head.delta.dice = result.dice;
+    head.delta.position = result.position;
+    head.delta.winner = result.won ? player_id : -1;
+
+    iovec frame[2] = {
+        { &head, sizeof(head) },
+        { const_cast<char*>(display.data()), display.size() },
+    };
+    channel_send(channel, &table->broadcast, frame, 2, &skip, true);
+}
+
+// Reactor mode: render the track once and send the STATE frame (plus
+// GAME_OVER after a win) to every seat over the table's broadcast channel.
+// Seats that render from shared memory already had their futex wake and
+// get no STATE frame. (Handlers send their own seat's, see seat_deliver.)
+void broadcast_roll(BroadcastChannel* channel, Table* table, int player_id,
+                    const RollResult& result) {
+    long long start = trace_begin();
+    SeatMask<MAX_PLAYERS> shm_seats;
+    shm_seats.clear();
+    for (int i = 0; i < channel->count; i++)
+        if (__atomic_load_n(&table->players[i].shm_view, __ATOMIC_RELAXED)) shm_seats.set(i);
+    bool all_shm = shm_seats.count() == channel->count;
+
+    if (!all_shm) send_state_frame(channel, table, player_id, result, shm_seats);
+
+    if (result.won) {
+        GameOverFrame over;
+        over.hdr = make_header(MSG_GAME_OVER, sizeof(GameOverMsg));
+        over.body.winner = player_id;
+
+        iovec iov = { &over, sizeof(over) };
+        channel_send(channel, &table->broadcast, &iov, 1);
+    }
+    trace_end(TR_BROADCAST, start, table->id, player_id);
+}
+
+// MSG_HELLO: wins from now on are credited to this name
+void set_player_name(Table* table, int player_id, const MsgView& msg) {
+    char name[MAX_NAME_LEN] = {};
+    if (msg.length == 0 || msg.length >= MAX_NAME_LEN) return;
+    std::memcpy(name, msg.payload, msg.length);
+    if (!score_name_valid(name)) return;
+
+    lock_table(table);
+    std::memcpy(table->players[player_id].name, name, MAX_NAME_LEN);
+    pthread_mutex_unlock(&table->game_mutex);
+}
+
+// MSG_SHM_VIEW (on = true) or disconnect (on = false): the seat reads
+// the table from shared memory and is woken by futex instead of STATE frames
+// Caller holds game_mutex
+void set_shm_view_locked(Table* table, int player_id, bool on) {
+    Player& player = table->players[player_id];
+    if (player.shm_view != static_cast<int>(on)) {
+        __atomic_store_n(&player.shm_view, on ? 1 : 0, __ATOMIC_RELAXED);
+        table->state_watchers += on ? 1 : -1;
+    }
+}
+
+void set_shm_view(Table* table, int player_id, bool on) {
+    lock_table(table);
+    set_shm_view_locked(table, player_id, on);
+    pthread_mutex_unlock(&table->game_mutex);
+}
+
+TimeoutMsg make_timeout(bool rolled, bool idle) {
+    TimeoutMsg timeout;
+    timeout.rolled = rolled;
+    timeout.idle = idle;
+    return timeout;
+}
+
+// A FIFO seat leaves the turn order (advance_turn() skips it) until its
+// player sends input again, see wake_idle_seat(). Caller holds game_mutex.
+void idle_seat_locked(Table* table, int player_id) {
+    Player& player = table->players[player_id];
+    if (player.idle) return;
+    set_seat_connected(table, player_id, false);
+    player.idle = 1;
+    player.missed_turns = 0;
+    state_write_begin(table);
+    table->game.active_players--;
+    state_write_end(table);
+    metric_add(&t_metrics->idle_seats);
+}
+
+// A FIFO client left a whole queue of control frames unread. Its FIFO
+// cannot be closed, so it is disconnected the way a player who keeps
+// missing deadlines is: the seat goes idle, the frames it never started
+// are dropped, and a TIMEOUT tells the client so if it reads again.
+void disconnect_stuck_seat(SharedData* shared, Table* table, int player_id, OutQueue* q,
+                           int fd) {
+    lock_table(table);
+    idle_seat_locked(table, player_id);
+    pthread_mutex_unlock(&table->game_mutex);
+
+    out_drop_unstarted(q);
+    TimeoutMsg timeout = make_timeout(false, true);
+    out_send_msg(q, fd, MSG_TIMEOUT, &timeout, sizeof(timeout));
+
+    log_ring_push(&shared->log_ring, "Table %d: Player %d stopped reading, now idle",
+                  table->id, player_id);
+    log_event(shared, table, table->game_number, EV_IDLE, player_id);
+    std::cout << "[SERVER] Table " << table->id << ": Player " << player_id
+              << " stopped reading, now idle\n";
+}
+
+// ---- Seat output (fork mode) ----
+// A handler is the only writer of its seat's out FIFO, so what it sends
+// goes through one outbound queue and is never torn by another process.
+// The handler of the player who rolled does not write to the other
+// seats: it renders the roll's STATE frame once into the table
+// (publish_state_frame), and each seat's handler queues a copy of those
+// bytes when it is woken for the next turn. A handler whose client is
+// behind only ever has the newest one queued.
+constexpr int OUT_RETRY_MS = 10;            // frames queued: retry the FIFO this often
+constexpr long IDLE_REFRESH_NS = 200000000; // idle seats see the track at most this late
+
+struct SeatOutput {
+    int player_id;
+    int fd;
+    OutQueue queue;
+    uint32_t roll_seq;      // last_roll.seq of the newest STATE frame sent
+};
+
+// Queue one frame for the seat; a client stuck for a whole queue of
+// control frames is disconnected (see disconnect_stuck_seat)
+void seat_send(Table* table, SeatOutput* out, const iovec* iov, int iovcnt, bool state) {
+    size_t len = 0;
+    for (int i = 0; i < iovcnt; i++) len += iov[i].iov_len;
+
+    bool queued = out_pending(&out->queue);
+    ssize_t n = out_send(&out->queue, out->fd, iov, iovcnt, state);
+    if (n < 0) {
+        disconnect_stuck_seat(g_shared, table, out->player_id, &out->queue, out->fd);
+        n = 0;
+    }
+
+    if (!queued) __atomic_add_fetch(&table->broadcast.syscalls, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&table->broadcast.bytes, n, __ATOMIC_RELAXED);
+    metric_add(&t_metrics->broadcast_bytes, n);
+    if (queued || n < static_cast<ssize_t>(len)) {
+        __atomic_add_fetch(&table->broadcast.drops, 1, __ATOMIC_RELAXED);
+        metric_add(&t_metrics->fifo_eagain);
+    }
+}
+
+void seat_send_msg(Table* table, SeatOutput* out, MsgType type, const void* payload = nullptr,
+                   uint32_t length = 0) {
+    MsgHeader hdr = make_header(type, length);
+    iovec iov[2] = {
+        { &hdr, sizeof(hdr) },
+        { const_cast<void*>(payload), length },
+    };
+    seat_send(table, out, iov, length ? 2 : 1, false);
+}
+
+// Render the STATE frame of a roll just committed into the table, once
+// for every seat's handler. Rolls at a table follow each other, but the
+// publisher of the previous one may still be writing when the next
+// arrives (or may have died doing so): the later one then skips
+// publishing and handlers render that frame themselves (see
+// seat_deliver), so nobody waits here.
+void publish_state_frame(Table* table, int player_id, const RollResult& result) {
+    if (!result.roll_seq || !result.state_frames) return;
+    if (!seq_try_write_begin(&table->frame_seq)) return;
+
+    std::string_view display = t_track.render(result.positions, result.num_players);
+    StateFrameHead head;
+    head.hdr = make_header(MSG_STATE, sizeof(StateDelta) + display.size());
+    head.delta.player_id = player_id;
+    head.delta.dice = result.dice;
+    head.delta.position = result.position;
+    head.delta.winner = result.won ? player_id : -1;
+
+    std::memcpy(table->frame, &head, sizeof(head));
+    std::memcpy(table->frame + sizeof(head), display.data(), display.size());
+    table->frame_length = sizeof(head) + display.size();
+    table->frame_roll = result.roll_seq;
+    seq_write_end(&table->frame_seq);
+}
+
+// Copy the table's STATE frame into t_frame if it shows roll `roll_seq`
+// and is not being written. Returns its length, 0 if the caller has to
+// render the frame itself.
+size_t copy_state_frame(const Table* table, uint32_t roll_seq) {
+    uint32_t start = table->frame_seq.load(std::memory_order_acquire);
+    if (start & 1) return 0;
+
+    uint32_t roll = __atomic_load_n(&table->frame_roll, __ATOMIC_RELAXED);
+    uint32_t length = __atomic_load_n(&table->frame_length, __ATOMIC_RELAXED);
+    if (roll != roll_seq || length > sizeof(t_frame)) return 0;
+
+    // Frames run to kilobytes: copied with memcpy rather than seq_copy()'s
+    // word loop, which costs as much as rendering; a copy that raced the
+    // next publisher fails the check below and is never sent
+    std::memcpy(t_frame, table->frame, length);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return table->frame_seq.load(std::memory_order_relaxed) == start ? length : 0;
+}
+
+// Retry what is queued, then send the seat the STATE frame (and GAME_OVER
+// after a win) for a roll it has not seen yet
+void seat_deliver(Table* table, int player_id, SeatOutput* out, const GameState& state) {
+    if (out_pending(&out->queue) && !out_flush(&out->queue, out->fd))
+        disconnect_stuck_seat(g_shared, table, player_id, &out->queue, out->fd);
+    if (state.last_roll.seq == out->roll_seq) return;
+    out->roll_seq = state.last_roll.seq;
+    long long start = trace_begin();
+
+    bool wants_state = !__atomic_load_n(&table->players[player_id].shm_view, __ATOMIC_RELAXED);
+    size_t length = wants_state ? copy_state_frame(table, state.last_roll.seq) : 0;
+    if (length > 0) {
+        iovec frame = { t_frame, length };
+        seat_send(table, out, &frame, 1, true);
+        metric_add(&t_metrics->broadcast_frames);
+    }
+    else if (wants_state) {
+        // Not published (yet): draw this one from the snapshot
+        std::string_view display = t_track.render(state.positions, state.num_players);
+
+        StateFrameHead head;
+        head.hdr = make_header(MSG_STATE, sizeof(StateDelta) + display.size());
+        head.delta.player_id = state.last_roll.player_id;
+        head.delta.dice = state.last_roll.dice;
+        head.delta.position = state.last_roll.position;
+        head.delta.winner = state.last_roll.winner;
+
+        iovec frame[2] = {
+            { &head, sizeof(head) },
+            { const_cast<char*>(display.data()), display.size() },
+        };
+        seat_send(table, out, frame, 2, true);
+        metric_add(&t_metrics->broadcast_frames);
+    }
+
+    if (state.last_roll.winner >= 0) {
+        GameOverMsg over;
+        over.winner = state.last_roll.winner;
+        seat_send_msg(table, out, MSG_GAME_OVER, &over, sizeof(over));
+    }
+    trace_end(TR_BROADCAST, start, table->id, player_id);
+}
+
+// How wait_for_roll() ended
+enum RollWait { ROLL_SENT, PLAYER_INPUT, DEADLINE_PASSED, PLAYER_GONE };
+
+// Block until the client sends MSG_ROLL, or until `timer_fd` (the turn
+// deadline, -1 for none) fires. The first `*late_rolls` ROLLs answer
+// prompts whose deadline already passed and are dropped. With
+// `late_rolls` null (an idle seat) any message returns, PLAYER_INPUT if
+// it was not a ROLL; meanwhile the seat is still sent the other rolls.
+// Queued output is written whenever the FIFO has room.
+// Blocks in ppoll() with `sleep_mask`, the only place a handler takes
+// SIGTERM while waiting for its player; input is read with it blocked, so
+// a stop never swallows a ROLL.
+template <size_t N>
+RollWait wait_for_roll(int fd, MsgReader<N>& reader, Table* table, int player_id,
+                       SeatOutput* out, const sigset_t* sleep_mask, int timer_fd,
+                       int* late_rolls) {
+    const timespec idle_refresh = { 0, IDLE_REFRESH_NS };
+    MsgView msg;
+    while (true) {
+        while (reader.next(msg)) {
+            if (msg.type == MSG_ROLL) {
+                if (!late_rolls || *late_rolls == 0) return ROLL_SENT;
+                (*late_rolls)--;
+                continue;
+            }
+            if (msg.type == MSG_HELLO) set_player_name(table, player_id, msg);
+            if (msg.type == MSG_SHM_VIEW) set_shm_view(table, player_id, true);
+            if (!late_rolls) return PLAYER_INPUT;
+        }
+        if (reader.error) return PLAYER_GONE;
+
+        pollfd pfds[3] = {
+            { fd, POLLIN, 0 },
+            { out->fd, static_cast<short>(out_pending(&out->queue) ? POLLOUT : 0), 0 },
+            { timer_fd, POLLIN, 0 },
+        };
+        if (ppoll(pfds, timer_fd >= 0 ? 3 : 2, late_rolls ? nullptr : &idle_refresh,
+                  sleep_mask) < 0 && errno != EINTR)
+            return PLAYER_GONE;
+
+        if (!late_rolls || pfds[1].revents) {
+            GameState state;
+            table_snapshot(table, &state);
+            seat_deliver(table, player_id, out, state);
+        }
+        if (pfds[0].revents) {
+            if (reader.fill(fd) <= 0) return PLAYER_GONE;
+        } else if (pfds[2].revents) {
+            return DEADLINE_PASSED;
+        }
+    }
+}
+
+// It is player_id's turn and they have not rolled yet
+inline bool turn_is_ready(const GameState& game, int player_id) {
+    return game.game_active && !game.game_over && game.current_turn == player_id &&
+           !game.turn_complete;
+}
+
+// Advance current_turn to the next connected seat (Round Robin), found
+// with a bit-scan of seats_connected. With nobody connected the turn
+// still moves one seat on. Caller holds game_mutex. Returns the new current_turn.
+int advance_turn(Table* table) {
+    int current = table->game.current_turn;
+    int next_turn = table->seats_connected.next_after(current, table->game.num_players);
+    if (next_turn < 0) next_turn = race_next_seat(current, table->game.num_players);
+
+    state_write_begin(table);
+    table->game.current_turn = next_turn;
+    table->game.turn_complete = 0;  // Reset flag for next turn
+    state_write_end(table);
+    return next_turn;
+}
+
+// The player on turn let the deadline pass. Counts the miss and returns
+// true once it is the idle_after'th in a row: a FIFO seat then goes idle
+// (disconnected, so advance_turn() skips it) until the player sends input
+// again; socket seats are dropped by the caller. Caller holds game_mutex.
+bool miss_deadline_locked(SharedData* shared, Table* table, int player_id) {
+    Player& player = table->players[player_id];
+    bool idle = shared->idle_after > 0 && ++player.missed_turns >= shared->idle_after;
+    if (idle && !table->dynamic) idle_seat_locked(table, player_id);
+
+    metric_add(&t_metrics->deadlines_expired);
+    metric_add(shared->deadline_roll ? &t_metrics->deadline_rolls : &t_metrics->deadline_skips);
+    log_ring_push(&shared->log_ring, "Table %d: Player %d missed the turn deadline (%s)%s",
+                  table->id, player_id, shared->deadline_roll ? "rolled for them" : "skipped",
+                  idle ? ", now idle" : "");
+    log_event(shared, table, table->game_number, EV_DEADLINE, player_id, shared->deadline_roll);
+    if (idle) log_event(shared, table, table->game_number, EV_IDLE, player_id);
+    return idle;
+}
+
+// An idle player sent input: the seat is connected again and plays from
+// its next turn. A table whose seats were all idle is stuck on an empty
+// seat; the turn moves on to the player now. Returns true if it did.
+bool wake_idle_seat(SharedData* shared, Table* table, int player_id) {
+    lock_table(table);
+    Player& player = table->players[player_id];
+    bool moved = false;
+    if (player.idle) {
+        player.idle = 0;
+        set_seat_connected(table, player_id, true);
+        state_write_begin(table);
+        table->game.active_players++;
+        state_write_end(table);
+
+        int turn = table->game.current_turn;
+        if (table->game.game_active && !table->game.game_over && !table->game.turn_complete &&
+            !table->players[turn].connected) {
+            advance_turn(table);
+            turn_wake(table);
+            moved = true;
+        }
+        log_ring_push(&shared->log_ring, "Table %d: Player %d is back", table->id, player_id);
+        log_event(shared, table, table->game_number, EV_RETURN, player_id);
+        metric_add(&t_metrics->idle_returns);
+    }
+    pthread_mutex_unlock(&table->game_mutex);
+    return moved;
+}
+
+// Socket tables: give the seats of departed players back to the listener
+// under their default names. Caller holds game_mutex. Returns empty seats.
+int release_empty_seats(Table* table) {
+    int empty = 0;
+    for (int i = 0; i < table->game.num_players; i++) {
+        if (table->players[i].connected) continue;
+        std::string name = default_player_name(table->id, i);
+        std::memset(table->players[i].name, 0, MAX_NAME_LEN);
+        strncpy(table->players[i].name, name.c_str(), MAX_NAME_LEN - 1);
+        empty++;
+    }
+    return empty;
+}
+
+// The socket of connection `session` closed. If a newer connection has
+// taken the seat since, nothing changes. Otherwise the player left: during
+// a game the seat stays reserved for their name until the game ends, and
+// a table everyone left is reset to waiting.
+// Returns true if the turn moved on and the next player must be prompted.
+bool unseat_player(SharedData* shared, Table* table, int player_id, uint32_t session) {
+    lock_table(table);
+    if (table->players[player_id].session != session) {
+        pthread_mutex_unlock(&table->game_mutex);
+        return false;
+    }
+    set_seat_connected(table, player_id, false);
+    set_shm_view_locked(table, player_id, false);
+    char name[MAX_NAME_LEN];
+    std::memcpy(name, table->players[player_id].name, MAX_NAME_LEN);
+
+    state_write_begin(table);
+    table->game.active_players--;
+    bool abandoned = table->game.game_active && table->game.active_players == 0;
+    if (abandoned) {
+        for (int i = 0; i < MAX_PLAYERS; i++) table->game.positions[i] = 0;
+        ranking_reset(&table->ranking, table->game.num_players);
+        table->game.game_active = 0;
+        table->game.current_turn = 0;
+        table->game.turn_complete = 0;
+    }
+    state_write_end(table);
+
+    log_event(shared, table, table->game_number, EV_LEAVE, player_id);
+    bool prompt = false;
+    if (abandoned) table->game_number++;   // the next game gets fresh dice
+    if (!table->game.game_active && !table->game.game_over)
+        release_empty_seats(table);
+    else if (table->game.game_active && table->game.current_turn == player_id) {
+        advance_turn(table);
+        prompt = true;
+    }
+
+    log_ring_push(&shared->log_ring, "Table %d: Player %d (%s) left%s", table->id, player_id,
+                  name, abandoned ? ", game abandoned" : "");
+    pthread_mutex_unlock(&table->game_mutex);
+
+    metric_add(&t_metrics->socket_leaves);
+    return prompt;
+}
+
+/* ========================================
+   SCHEDULER THREAD - Round Robin Turn Management
+   ======================================== */
+
+// Called by a handler once its roll is committed (turn_complete set)
+void notify_scheduler(SharedData* shared, Table* table) {
+    shared->sched_queue.push(table->id);
+    sem_post(&shared->sched_sem);
+}
+
+void* scheduler_thread(void* arg) {
+    SharedData* shared = static_cast<SharedData*>(arg);
+
+    // Tables waiting out the pause between games: (deadline, table id).
+    // Every pause is game_pause_ns long, so deadlines arrive in order.
+    std::deque<std::pair<long long, int>> pending_resets;
+
+    metrics_attach(g_metrics, "scheduler");
+    trace_attach("scheduler");
+    std::cout << "[SERVER] Scheduler thread started\n";
+
+    while (true) {
+        // Sleep until a handler commits a roll or a reset falls due
+        if (pending_resets.empty()) {
+            sem_wait(&shared->sched_sem);
+        } else {
+            long long deadline = pending_resets.front().first;
+            timespec ts{};
+            ts.tv_sec = deadline / 1000000000LL;
+            ts.tv_nsec = deadline % 1000000000LL;
+            sem_clockwait(&shared->sched_sem, CLOCK_MONOTONIC, &ts);
+        }
+
+        int table_id;
+        while (shared->sched_queue.pop(table_id)) {
+            long long start = trace_begin();
+            Table* table = get_table(table_id);
+            lock_table(table);
+
+            if (!table->game.turn_complete) {
+                pthread_mutex_unlock(&table->game_mutex);
+                continue;
+            }
+
+            // Handle game over: pause between games, then start a new one
+            if (table->game.game_over) {
+                state_write_begin(table);
+                table->game.turn_complete = 0;
+                state_write_end(table);
+                pthread_mutex_unlock(&table->game_mutex);
+                pending_resets.emplace_back(monotonic_ns() + shared->game_pause_ns, table_id);
+                continue;
+            }
+
+            // Advance to next player and wake their handler
+            int next_turn = advance_turn(table);
+            turn_wake(table);
+            pthread_mutex_unlock(&table->game_mutex);
+
+            // Log turn change
+            log_ring_push(&shared->log_ring, "[SCHEDULER] Table %d: Turn advanced to Player %d",
+                          table_id, next_turn);
+
+            std::cout << "[SCHEDULER] Table " << table_id << ": Turn -> Player " << next_turn << "\n";
+            trace_end(TR_SCHEDULE, start, table_id, -1, next_turn);
+        }
+
+        long long now = monotonic_ns();
+        while (!pending_resets.empty() && pending_resets.front().first <= now) {
+            reset_game(shared, get_table(pending_resets.front().second));
+            pending_resets.pop_front();
+        }
+    }
+
+    return nullptr;
+}
+
+/* ========================================
+   PERSISTENT SCORING - Journaled Score Store
+   ======================================== */
+
+// Queue a win for the scorekeeper. Handlers never touch the score files,
+// so a win costs one queue push instead of a file rewrite on the turn path.
+void submit_win(SharedData* shared, Table* table, const char* name) {
+    ScoreEvent event{};
+    std::memcpy(event.name, name, MAX_NAME_LEN);
+    event.table_id = table->id;
+
+    // Full queue: the scorekeeper is behind on fdatasync, wait for it
+    while (!shared->score_queue.push(event)) {
+        sem_post(&shared->score_sem);
+        usleep(100);
+    }
+    sem_post(&shared->score_sem);
+}
+
+// Journal every queued win, one group commit per batch.
+// Caller holds score_mutex. Returns the number of wins committed.
+int commit_score_events(SharedData* shared) {
+    constexpr int BATCH = 256;
+    ScoreEvent batch[BATCH];
+    int total = 0;
+
+    while (true) {
+        int count = 0;
+        while (count < BATCH && shared->score_queue.pop(batch[count])) count++;
+        if (count == 0) break;
+
+        long long start = monotonic_ns();
+        if (!score_store_append(&g_scores, batch, count)) {
+            log_ring_push(&shared->log_ring, "[SCORES] Journal write failed, %d win(s) lost",
+                          count);
+            continue;
+        }
+        metric_record(&t_metrics->score_commit, monotonic_ns() - start);
+        metric_add(&t_metrics->score_commits);
+        metric_add(&t_metrics->score_events, count);
+
+        for (int i = 0; i < count; i++) {
+            log_ring_push(&shared->log_ring, "[SCORES] %s: total wins = %lld (table %d)",
+                          batch[i].name, g_scores.wins[batch[i].name], batch[i].table_id);
+        }
+        total += count;
+    }
+
+    if (g_scores.journal_records >= SCORE_COMPACT_EVERY) score_store_compact(&g_scores);
+    return total;
+}
+
+void* scorekeeper_thread(void* arg) {
+    SharedData* shared = static_cast<SharedData*>(arg);
+
+    metrics_attach(g_metrics, "scorekeeper");
+    std::cout << "[SERVER] Scorekeeper thread started\n";
+
+    while (true) {
+        if (sem_wait(&shared->score_sem) < 0) continue;
+
+        // Wins that arrive while one batch is being fdatasync'd are picked
+        // up by the next pass and share its commit
+        do {
+            metrics_lock(&shared->score_mutex, &t_metrics->score_mutex_wait);
+            commit_score_events(shared);
+            pthread_mutex_unlock(&shared->score_mutex);
+        } while (sem_trywait(&shared->score_sem) == 0);
+    }
+
+    return nullptr;
+}
+
+/* ========================================
+   GAME RESET - Multi-Game Support
+   ======================================== */
+void reset_game(SharedData* shared, Table* table) {
+    std::cout << "[SERVER] Table " << table->id << ": Resetting game state for new game...\n";
+
+    lock_table(table);
+
+    // Socket tables free the seats of players who left during the game;
+    // the next game starts once the listener has filled them again
+    bool full = true;
+    if (table->dynamic) full = release_empty_seats(table) == 0;
+
+    state_write_begin(table);
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        table->game.positions[i] = 0;
+    }
+    ranking_reset(&table->ranking, table->game.num_players);
+
+    // First turn to the first seat still playing (idle ones are skipped)
+    int first = table->seats_connected.find_from(0, table->game.num_players);
+    table->game.current_turn = first >= 0 ? first : 0;
+    table->game.winner = -1;
+    table->game.game_over = 0;
+    table->game.game_active = full ? 1 : 0;
+    table->game.turn_complete = 0;
+    state_write_end(table);
+    table->turn_committed_ns = 0;
+    table->game_number++;
+
+    if (!full) {
+        log_ring_push(&shared->log_ring, "========== TABLE %d: WAITING FOR PLAYERS ==========",
+                      table->id);
+        pthread_mutex_unlock(&table->game_mutex);
+        return;
+    }
+
+    log_ring_push(&shared->log_ring, "========== TABLE %d: NEW GAME STARTED ==========", table->id);
+    seed_game_dice(shared, table);
+
+    turn_wake(table);
+    pthread_mutex_unlock(&table->game_mutex);
+}
+
+// Console leaderboard after a roll, drawn from the roller's snapshot
+// outside game_mutex: one write to std::cout instead of a dozen small ones
+void print_leaderboard(const RollResult& result)
+{
+    static thread_local char text[LEADERBOARD_TEXT_MAX];
+    std::cout.write(text, format_leaderboard(text, result.positions, result.order,
+                                             result.num_players));
+}
+
+/* ========================================
+   PLAYER HANDLER - One Forked Process per Seat
+   ======================================== */
+
+// A handler that replaces a crashed one, or the previous server's after a
+// warm restart, drops the ROLL sent for the turn that was lost (the turn is
+// prompted again), keeping names and view requests sent since
+template <size_t N>
+void drain_stale_input(int fd, MsgReader<N>& reader, Table* table, int player_id) {
+    int flags = fcntl(fd, F_GETFL);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+    MsgView msg;
+    while (!reader.error && reader.fill(fd) > 0) {
+        while (reader.next(msg)) {
+            if (msg.type == MSG_HELLO) set_player_name(table, player_id, msg);
+            if (msg.type == MSG_SHM_VIEW) set_shm_view(table, player_id, true);
+        }
+    }
+    reader.reset();
+    fcntl(fd, F_SETFL, flags);
+}
+
+void player_handler(SharedData* shared, Table* table, int player_id, bool respawned) {
+    metrics_attach(g_metrics, "handler");
+    char trace_name[TRACE_NAME_LEN];
+    snprintf(trace_name, sizeof(trace_name), "handler %d.%d", table->id, player_id);
+    trace_attach(trace_name);
+
+    // SIGTERM (warm restart) is only taken while waiting with nothing held
+    sigset_t term, sleep_mask;
+    sigemptyset(&term);
+    sigaddset(&term, SIGTERM);
+    sigprocmask(SIG_BLOCK, &term, &sleep_mask);
+    sigdelset(&sleep_mask, SIGTERM);
+    sigset_t run_mask = sleep_mask;
+    sigaddset(&run_mask, SIGTERM);
+
+    std::string in_fifo  = fifo_path(table->id, player_id, "in");
+    std::string out_fifo = fifo_path(table->id, player_id, "out");
+
+    int fd_in  = open(in_fifo.c_str(), O_RDWR);
+    int fd_out = open(out_fifo.c_str(), O_RDWR);
+
+    if (fd_in < 0 || fd_out < 0) {
+        perror("FIFO open in child");
+        exit(1);
+    }
+
+    // Everything for this seat goes out through one queue (see SeatOutput)
+    fcntl(fd_out, F_SETFL, fcntl(fd_out, F_GETFL) | O_NONBLOCK);
+    SeatOutput out;
+    out.player_id = player_id;
+    out.fd = fd_out;
+    GameState start;
+    table_snapshot(table, &start);
+    out.roll_seq = start.last_roll.seq;
+
+    // Turn deadline, armed with every prompt
+    int timer_fd = -1;
+    itimerspec deadline{};
+    if (shared->turn_deadline_ns > 0) {
+        timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+        deadline.it_value.tv_sec = shared->turn_deadline_ns / 1000000000LL;
+        deadline.it_value.tv_nsec = shared->turn_deadline_ns % 1000000000LL;
+    }
+    int late_rolls = 0;   // prompts the deadline answered, still owed a ROLL
+
+    MsgReader<256> reader;
+    if (respawned) metric_add(&t_metrics->handler_respawns);
+    if (respawned || shared->restarts) drain_stale_input(fd_in, reader, table, player_id);
+
+    table->players[player_id].handler_pid = getpid();
+    seat_player(shared, table, player_id);
+
+    // Player event loop
+    while (true) {
+        // Idle: the turn passes this seat until the player sends input. A
+        // ROLL doing so answers one of the prompts they missed.
+        if (__atomic_load_n(&table->players[player_id].idle, __ATOMIC_RELAXED)) {
+            RollWait input = wait_for_roll(fd_in, reader, table, player_id, &out, &sleep_mask,
+                                           -1, nullptr);
+            if (input == PLAYER_GONE) break;
+            if (input == ROLL_SENT && late_rolls > 0) late_rolls--;
+            wake_idle_seat(shared, table, player_id);
+            continue;
+        }
+
+        // Wait for my turn (woken by the scheduler, reset_game or a win).
+        // Every seat at the table is woken; each sends its player the roll
+        // it has not seen, and all but the one on turn go back to sleep
+        // without taking game_mutex. The roll is sent before YOUR_TURN.
+        long long waited = trace_begin();
+        while (true) {
+            uint32_t seen = table->turn_seq.load(std::memory_order_acquire);
+            GameState state;
+            table_snapshot(table, &state);
+            seat_deliver(table, player_id, &out, state);
+            if (turn_is_ready(state, player_id)) {
+                lock_table(table);
+                if (turn_is_ready(table->game, player_id)) break;
+                pthread_mutex_unlock(&table->game_mutex);
+                continue;
+            }
+            sigprocmask(SIG_SETMASK, &sleep_mask, nullptr);
+            seq_wait(&table->turn_seq, seen, out_pending(&out.queue) ? OUT_RETRY_MS : 1000);
+            sigprocmask(SIG_SETMASK, &run_mask, nullptr);
+        }
+
+        trace_end(TR_TURN_WAIT, waited, table->id, player_id);
+        long long prompted = trace_begin();
+        record_handoff(table);
+
+        // It's my turn! Prompted outside game_mutex: a client stuck for a
+        // whole queue is disconnected, which takes the lock itself.
+        pthread_mutex_unlock(&table->game_mutex);
+        seat_send_msg(table, &out, MSG_YOUR_TURN);
+        trace_end(TR_PROMPT, prompted, table->id, player_id);
+        if (__atomic_load_n(&table->players[player_id].idle, __ATOMIC_RELAXED)) {
+            // That happened to this prompt: pass the turn on now rather
+            // than hold the table for a deadline nobody will answer
+            lock_table(table);
+            bool passed = turn_is_ready(table->game, player_id);
+            if (passed) {
+                state_write_begin(table);
+                table->game.turn_complete = 1;
+                state_write_end(table);
+                table->turn_committed_ns = monotonic_ns();
+            }
+            pthread_mutex_unlock(&table->game_mutex);
+            if (passed) notify_scheduler(shared, table);
+            continue;
+        }
+        if (timer_fd >= 0) timerfd_settime(timer_fd, 0, &deadline, nullptr);
+
+        // Wait for player action
+        long long thinking = trace_begin();
+        RollWait action = wait_for_roll(fd_in, reader, table, player_id, &out, &sleep_mask,
+                                        timer_fd, &late_rolls);
+        trace_end(TR_ROLL_WAIT, thinking, table->id, player_id);
+        if (action == PLAYER_GONE) {
+            // Player disconnected: give the turn away so the table keeps moving
+            set_shm_view(table, player_id, false);
+            lock_table(table);
+            set_seat_connected(table, player_id, false);
+            table->players[player_id].handler_pid = 0;
+            state_write_begin(table);
+            table->game.turn_complete = 1;
+            state_write_end(table);
+            pthread_mutex_unlock(&table->game_mutex);
+            notify_scheduler(shared, table);
+            break;
+        }
+
+        // Too slow: roll for the player or skip them. The ROLL they still
+        // owe for this prompt is dropped when it comes.
+        bool roll = true;
+        if (action == DEADLINE_PASSED) {
+            lock_table(table);
+            bool idle = miss_deadline_locked(shared, table, player_id);
+            pthread_mutex_unlock(&table->game_mutex);
+            TimeoutMsg timeout = make_timeout(shared->deadline_roll, idle);
+            seat_send_msg(table, &out, MSG_TIMEOUT, &timeout, sizeof(timeout));
+            late_rolls++;
+            roll = shared->deadline_roll;
+        }
+
+        if (roll) {
+            // Roll dice (server-side randomness, this seat's stream)
+            int dice = dice_roll(&table->dice[player_id]);
+
+            RollResult result = commit_roll(table, player_id, dice, action == DEADLINE_PASSED);
+            publish_state_frame(table, player_id, result);
+            __atomic_add_fetch(&table->broadcast.broadcasts, result.won ? 2 : 1,
+                               __ATOMIC_RELAXED);
+
+            GameState state;
+            table_snapshot(table, &state);
+            seat_deliver(table, player_id, &out, state);
+            announce_roll(shared, table, player_id, result);
+            if (result.won) seat_send_msg(table, &out, MSG_WIN);
+        }
+
+        // Signal turn complete and wake the scheduler immediately
+        lock_table(table);
+        state_write_begin(table);
+        table->game.turn_complete = 1;
+        state_write_end(table);
+        table->turn_committed_ns = monotonic_ns();
+        pthread_mutex_unlock(&table->game_mutex);
+        notify_scheduler(shared, table);
+    }
+
+    if (timer_fd >= 0) close(timer_fd);
+    close(fd_in);
+    close(fd_out);
+    exit(0);
+}
+
+/* ========================================
+   CRASH RECOVERY - Respawning Player Handlers
+   ======================================== */
+
+// Parent side of a handler crash. Taking the table lock repairs the table
+// if the handler died holding it; a turn the handler was serving is ended
+// so the table moves on. A crash costs its seat that one turn.
+void recover_seat(SharedData* shared, Table* table, int player_id) {
+    lock_table(table);
+    bool lost_turn = table->game.game_active && table->game.current_turn == player_id &&
+                     !table->game.turn_complete;
+    if (lost_turn) {
+        state_write_begin(table);
+        table->game.turn_complete = 1;
+        state_write_end(table);
+    }
+    pthread_mutex_unlock(&table->game_mutex);
+
+    if (lost_turn) notify_scheduler(shared, table);
+}
+
+// Fork the handler for one seat. Returns its pid, or -1 if fork failed.
+pid_t spawn_handler(SharedData* shared, Table* table, int player_id, bool respawn) {
+    pid_t pid = fork();
+    if (pid < 0) perror("fork");
+
+    if (pid == 0) {
+        // Keep no parent descriptors: a handler holding a socket player's
+        // fd or the listener's would keep them open after the parent closes them
+        close_range(3, ~0U, 0);
+        player_handler(shared, table, player_id, respawn);
+    }
+    return pid;
+}
+
+// Reap exited handlers (main thread, after SIGCHLD). A handler that exits
+// normally saw its player leave; one killed by a signal crashed and is
+// replaced in the same seat. `handlers` holds the pid per seat.
+void reap_handlers(SharedData* shared, std::vector<pid_t>* handlers, int num_players) {
+    int status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        auto slot = std::find(handlers->begin(), handlers->end(), pid);
+        if (slot == handlers->end()) continue;
+        *slot = -1;
+        metrics_release(g_metrics, pid);
+        if (!WIFSIGNALED(status)) continue;
+
+        int seat = slot - handlers->begin();
+        Table* table = get_table(seat / num_players);
+        int player_id = seat % num_players;
+
+        recover_seat(shared, table, player_id);
+        *slot = spawn_handler(shared, table, player_id, true);
+
+        log_ring_push(&shared->log_ring, "Table %d: handler for Player %d died (signal %d), respawned",
+                      table->id, player_id, WTERMSIG(status));
+        std::cout << "[SERVER] Table " << table->id << ": Handler for player " << player_id
+                  << " died (signal " << WTERMSIG(status) << "), respawned\n";
+    }
+}
+
+/* ========================================
+   REACTOR MODE - epoll Turn State Machines
+   ======================================== */
+
+// In reactor mode no handlers are forked. Each reactor thread owns the
+// tables with id % count == index, keeps every seat's FIFOs open and runs
+// the turn logic inline when the player on turn sends input:
+//   prompt -> (ROLL) -> commit -> broadcast -> advance -> prompt ...
+// Game-over pauses and turn deadlines are timed with a timerfd in the
+// same epoll set.
+// Socket tables (see PLAYER LISTENER) are owned the same way; their seats
+// arrive through the inbox and use one socket for both directions.
+// Frames a seat has not taken yet wait in its channel's outbound queue; the
+// reactor watches the descriptor for EPOLLOUT only while one is queued.
+constexpr uint64_t REACTOR_TIMER_KEY = ~0ULL;
+constexpr uint64_t REACTOR_INBOX_KEY = ~0ULL - 1;
+constexpr uint64_t REACTOR_OUT_KEY = 1ULL << 62;   // | seat key: a FIFO seat's out side
+
+// A socket player seated by the listener, handed to the owning reactor
+struct SeatHandoff {
+    int table_id;
+    int player_id;
+    int fd;
+    uint32_t session;   // Player::session this connection holds the seat with
+    bool started;       // this seat completed the table and started the game
+};
+
+// Turn deadline of one prompt. Every deadline is turn_deadline_ns after
+// its prompt, so they expire in the order they were set; one whose table
+// has been prompted again since is stale and ignored.
+struct TurnDeadline {
+    long long at;
+    int table_id;
+    uint64_t prompt;
+};
+
+struct Reactor {
+    SharedData* shared;
+    pthread_t thread;
+    int index;
+    int count;
+    int fifo_tables;                         // tables 0..fifo_tables-1 are played over FIFOs
+    int epoll_fd;
+    int timer_fd;
+    int inbox_fd;                            // eventfd, signalled by the listener
+    pthread_mutex_t inbox_mutex = PTHREAD_MUTEX_INITIALIZER;
+    std::vector<SeatHandoff> inbox;
+    std::vector<int> fd_in;                  // local table * MAX_PLAYERS + seat
+    std::vector<MsgReader<256>> readers;     // same indexing as fd_in
+    std::vector<uint32_t> sessions;          // same indexing, socket seats only
+    std::vector<int> late_rolls;             // same indexing, ROLLs owed for expired prompts
+    std::vector<BroadcastChannel> channels;  // per local table, also used for prompts
+    std::vector<uint64_t> prompts;           // per local table, prompts sent so far
+    std::deque<std::pair<long long, int>> pending_resets;
+    std::deque<TurnDeadline> deadlines;
+    std::vector<int> stuck_tables;           // tables with seats in BroadcastChannel::stuck
+};
+
+int& reactor_fd_in(Reactor* r, int table_id, int player_id) {
+    return r->fd_in[(table_id / r->count) * MAX_PLAYERS + player_id];
+}
+
+MsgReader<256>& reactor_reader(Reactor* r, int table_id, int player_id) {
+    return r->readers[(table_id / r->count) * MAX_PLAYERS + player_id];
+}
+
+uint32_t& reactor_session(Reactor* r, int table_id, int player_id) {
+    return r->sessions[(table_id / r->count) * MAX_PLAYERS + player_id];
+}
+
+int& reactor_late_rolls(Reactor* r, int table_id, int player_id) {
+    return r->late_rolls[(table_id / r->count) * MAX_PLAYERS + player_id];
+}
+
+BroadcastChannel& reactor_channel(Reactor* r, int table_id) {
+    return r->channels[table_id / r->count];
+}
+
+// Make room for a socket table created after the reactor started
+void reactor_adopt_table(Reactor* r, int table_id) {
+    size_t local = table_id / r->count + 1;
+    if (r->channels.size() >= local) return;
+
+    r->fd_in.resize(local * MAX_PLAYERS, -1);
+    r->readers.resize(local * MAX_PLAYERS);
+    r->sessions.resize(local * MAX_PLAYERS);
+    r->late_rolls.resize(local * MAX_PLAYERS);
+    r->prompts.resize(local);
+
+    BroadcastChannel empty;
+    empty.count = get_table(table_id)->game.num_players;
+    std::fill(empty.fds, empty.fds + MAX_PLAYERS, -1);
+    empty.stuck.clear();
+    r->channels.resize(local, empty);
+}
+
+// Watch a seat for EPOLLOUT while it has frames queued, and stop once they
+// are written. A socket seat shares one registration for both directions.
+void reactor_watch_out(Reactor* r, int table_id, int player_id) {
+    BroadcastChannel& channel = reactor_channel(r, table_id);
+    OutQueue& queue = channel.out[player_id];
+    int fd = channel.fds[player_id];
+    bool want = out_pending(&queue);
+    if (fd < 0 || want == queue.armed) return;
+
+    epoll_event ev{};
+    uint64_t key = static_cast<uint64_t>(table_id) * MAX_PLAYERS + player_id;
+    if (fd == reactor_fd_in(r, table_id, player_id)) {
+        ev.events = EPOLLIN | (want ? uint32_t(EPOLLOUT) : 0u);
+        ev.data.u64 = key;
+        epoll_ctl(r->epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+    } else {
+        ev.events = EPOLLOUT;
+        ev.data.u64 = key | REACTOR_OUT_KEY;
+        epoll_ctl(r->epoll_fd, want ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, fd, &ev);
+    }
+    queue.armed = want;
+}
+
+// After sending to a table: arm EPOLLOUT for seats that fell behind, and
+// note stuck ones to be dealt with between events (see reactor_unstick)
+void reactor_sent(Reactor* r, int table_id) {
+    BroadcastChannel& channel = reactor_channel(r, table_id);
+    for (int i = 0; i < channel.count; i++) reactor_watch_out(r, table_id, i);
+    if (channel.stuck.count() > 0) r->stuck_tables.push_back(table_id);
+}
+
+void reactor_send_msg(Reactor* r, Table* table, int player_id, MsgType type,
+                      const void* payload = nullptr, uint32_t length = 0) {
+    BroadcastChannel& channel = reactor_channel(r, table->id);
+    channel_send_msg(&channel, player_id, type, payload, length);
+    reactor_watch_out(r, table->id, player_id);
+    if (channel.stuck.test(player_id)) r->stuck_tables.push_back(table->id);
+}
+
+// EPOLLOUT: the seat has room again
+void reactor_handle_output(Reactor* r, int table_id, int player_id) {
+    BroadcastChannel& channel = reactor_channel(r, table_id);
+    int fd = channel.fds[player_id];
+    if (fd < 0) return;
+    if (!out_flush(&channel.out[player_id], fd)) {
+        channel.stuck.set(player_id);
+        r->stuck_tables.push_back(table_id);
+    }
+    reactor_watch_out(r, table_id, player_id);
+}
+
+void reactor_arm_timer(Reactor* r) {
+    long long deadline = 0;
+    if (!r->pending_resets.empty()) deadline = r->pending_resets.front().first;
+    if (!r->deadlines.empty() && (!deadline || r->deadlines.front().at < deadline))
+        deadline = r->deadlines.front().at;
+
+    itimerspec its{};
+    its.it_value.tv_sec = deadline / 1000000000LL;
+    its.it_value.tv_nsec = deadline % 1000000000LL;
+    timerfd_settime(r->timer_fd, TFD_TIMER_ABSTIME, &its, nullptr);
+}
+
+// Tell the player on turn to roll, and start the turn deadline
+void reactor_prompt(Reactor* r, Table* table) {
+    long long start = trace_begin();
+    lock_table(table);
+    bool active = table->game.game_active && !table->game.game_over;
+    int player_id = table->game.current_turn;
+    if (active) record_handoff(table);
+    pthread_mutex_unlock(&table->game_mutex);
+
+    // A socket seat whose handoff is still in the inbox is prompted on attach
+    if (active) reactor_send_msg(r, table, player_id, MSG_YOUR_TURN);
+
+    uint64_t prompt = ++r->prompts[table->id / r->count];
+    if (active && r->shared->turn_deadline_ns > 0) {
+        r->deadlines.push_back({ monotonic_ns() + r->shared->turn_deadline_ns, table->id, prompt });
+        if (r->deadlines.size() == 1) reactor_arm_timer(r);
+    }
+    trace_end(TR_PROMPT, start, table->id, player_id);
+}
+
+// Play the turn of the player on turn: roll, broadcast, move on
+void reactor_play(Reactor* r, int table_id, int player_id, bool auto_roll) {
+    long long start = trace_begin();
+    Table* table = get_table(table_id);
+    BroadcastChannel& channel = reactor_channel(r, table_id);
+
+    // Roll dice (server-side randomness, this seat's stream)
+    int dice = dice_roll(&table->dice[player_id]);
+
+    RollResult result = commit_roll(table, player_id, dice, auto_roll);
+    broadcast_roll(&channel, table, player_id, result);
+    reactor_sent(r, table_id);
+    announce_roll(r->shared, table, player_id, result);
+    if (result.won) reactor_send_msg(r, table, player_id, MSG_WIN);
+
+    lock_table(table);
+    table->turn_committed_ns = monotonic_ns();
+    int next_turn = result.won ? -1 : advance_turn(table);
+    pthread_mutex_unlock(&table->game_mutex);
+
+    if (result.won) {
+        // Handle game over: pause between games, then start a new one
+        r->pending_resets.emplace_back(monotonic_ns() + r->shared->game_pause_ns, table_id);
+        if (r->pending_resets.size() == 1) reactor_arm_timer(r);
+        trace_end(TR_PLAY, start, table_id, player_id, dice);
+        return;
+    }
+
+    log_ring_push(&r->shared->log_ring, "[SCHEDULER] Table %d: Turn advanced to Player %d",
+                  table_id, next_turn);
+    std::cout << "[SCHEDULER] Table " << table_id << ": Turn -> Player " << next_turn << "\n";
+
+    reactor_prompt(r, table);
+    trace_end(TR_PLAY, start, table_id, player_id, dice);
+}
+
+// The player sent MSG_ROLL: play the turn if it is theirs
+void reactor_roll(Reactor* r, int table_id, int player_id) {
+    Table* table = get_table(table_id);
+
+    int& late = reactor_late_rolls(r, table_id, player_id);
+    if (late > 0) {
+        late--;   // answers a prompt whose deadline already passed
+        return;
+    }
+
+    // A roll outside the player's turn is dropped, as a handler would
+    // never have asked for it. Only this reactor changes the turn, so a
+    // snapshot is enough.
+    GameState state;
+    table_snapshot(table, &state);
+    bool my_turn = state.game_active && !state.game_over && state.current_turn == player_id;
+    if (my_turn) reactor_play(r, table_id, player_id, false);
+}
+
+void reactor_drop_seat(Reactor* r, int table_id, int player_id);
+
+// The turn deadline of the player on turn passed: roll for them or skip
+// them. A socket player idle for too long is disconnected.
+void reactor_deadline(Reactor* r, int table_id) {
+    Table* table = get_table(table_id);
+    GameState state;
+    table_snapshot(table, &state);
+    if (!state.game_active || state.game_over) return;
+    int player_id = state.current_turn;
+
+    lock_table(table);
+    bool idle = miss_deadline_locked(r->shared, table, player_id);
+    pthread_mutex_unlock(&table->game_mutex);
+
+    TimeoutMsg timeout = make_timeout(r->shared->deadline_roll, idle);
+    reactor_send_msg(r, table, player_id, MSG_TIMEOUT, &timeout, sizeof(timeout));
+    reactor_late_rolls(r, table_id, player_id)++;
+
+    if (r->shared->deadline_roll) {
+        reactor_play(r, table_id, player_id, true);
+    } else {
+        lock_table(table);
+        table->turn_committed_ns = monotonic_ns();
+        int next_turn = advance_turn(table);
+        pthread_mutex_unlock(&table->game_mutex);
+
+        log_ring_push(&r->shared->log_ring, "[SCHEDULER] Table %d: Turn advanced to Player %d",
+                      table_id, next_turn);
+        std::cout << "[SCHEDULER] Table " << table_id << ": Turn -> Player " << next_turn << "\n";
+        reactor_prompt(r, table);
+    }
+
+    if (idle && table->dynamic && reactor_fd_in(r, table_id, player_id) >= 0)
+        reactor_drop_seat(r, table_id, player_id);
+}
+
+// A socket player hung up: free the descriptors and give the turn away
+void reactor_drop_seat(Reactor* r, int table_id, int player_id) {
+    Table* table = get_table(table_id);
+    int& fd = reactor_fd_in(r, table_id, player_id);
+
+    epoll_ctl(r->epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    fd = -1;
+    BroadcastChannel& channel = reactor_channel(r, table_id);
+    channel.fds[player_id] = -1;
+    out_reset(&channel.out[player_id]);
+    channel.out[player_id].armed = false;
+    channel.stuck.set(player_id, false);
+    reactor_reader(r, table_id, player_id).reset();
+
+    if (unseat_player(r->shared, table, player_id, reactor_session(r, table_id, player_id)))
+        reactor_prompt(r, table);
+}
+
+// Attach the sockets the listener seated at this reactor's tables
+void reactor_handle_inbox(Reactor* r) {
+    uint64_t count;
+    read(r->inbox_fd, &count, sizeof(count));
+
+    std::vector<SeatHandoff> arrived;
+    pthread_mutex_lock(&r->inbox_mutex);
+    arrived.swap(r->inbox);
+    pthread_mutex_unlock(&r->inbox_mutex);
+
+    for (const SeatHandoff& seat : arrived) {
+        Table* table = get_table(seat.table_id);
+        reactor_adopt_table(r, seat.table_id);
+
+        // A rejoin can arrive before the old socket's hangup: drop that one
+        int& fd = reactor_fd_in(r, seat.table_id, seat.player_id);
+        if (fd >= 0) {
+            epoll_ctl(r->epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+            close(fd);
+        }
+
+        fd = seat.fd;
+        reactor_session(r, seat.table_id, seat.player_id) = seat.session;
+        reactor_late_rolls(r, seat.table_id, seat.player_id) = 0;
+        BroadcastChannel& channel = reactor_channel(r, seat.table_id);
+        channel.fds[seat.player_id] = seat.fd;
+        out_reset(&channel.out[seat.player_id]);
+        channel.out[seat.player_id].armed = false;
+        channel.stuck.set(seat.player_id, false);
+        reactor_reader(r, seat.table_id, seat.player_id).reset();
+
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = static_cast<uint64_t>(seat.table_id) * MAX_PLAYERS + seat.player_id;
+        epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, seat.fd, &ev);
+
+        // Prompt if the game just started, or the turn is already this seat's
+        GameState state;
+        table_snapshot(table, &state);
+        bool my_turn = state.game_active && !state.game_over &&
+                       state.current_turn == seat.player_id;
+        if (seat.started || my_turn) reactor_prompt(r, table);
+    }
+}
+
+// Seats that stopped reading for a whole queue, or whose socket failed.
+// Run between events, never from inside a send: a socket player is
+// disconnected like one that hung up, a FIFO seat goes idle (see
+// disconnect_stuck_seat).
+void reactor_unstick(Reactor* r) {
+    std::vector<int> tables;
+    tables.swap(r->stuck_tables);
+    for (int table_id : tables) {
+        BroadcastChannel& channel = reactor_channel(r, table_id);
+        for (int i = channel.stuck.find_from(0, channel.count); i >= 0;
+             i = channel.stuck.find_from(i + 1, channel.count)) {
+            channel.stuck.set(i, false);
+            if (channel.fds[i] < 0) continue;
+            if (get_table(table_id)->dynamic) {
+                std::cout << "[SERVER] Table " << table_id << ": Player " << i
+                          << " stopped reading, disconnected\n";
+                reactor_drop_seat(r, table_id, i);
+            } else {
+                disconnect_stuck_seat(r->shared, get_table(table_id), i, &channel.out[i],
+                                      channel.fds[i]);
+                reactor_watch_out(r, table_id, i);
+            }
+        }
+    }
+}
+
+void reactor_handle_input(Reactor* r, int table_id, int player_id) {
+    int fd = reactor_fd_in(r, table_id, player_id);
+    if (fd < 0) return;   // dropped earlier in this batch of events
+    MsgReader<256>& reader = reactor_reader(r, table_id, player_id);
+    ssize_t n = reader.fill(fd);
+    if (n == 0 || (n < 0 && errno != EAGAIN)) {
+        if (get_table(table_id)->dynamic) reactor_drop_seat(r, table_id, player_id);
+        return;
+    }
+    if (n < 0) return;
+
+    // Any input from an idle player brings them back (only this reactor
+    // changes the flag). A ROLL doing so answers one of the prompts they
+    // missed and is not played.
+    Table* table = get_table(table_id);
+    MsgView msg;
+    while (reader.next(msg)) {
+        if (table->players[player_id].idle) {
+            int& late = reactor_late_rolls(r, table_id, player_id);
+            if (msg.type == MSG_ROLL && late > 0) late--;
+            if (wake_idle_seat(r->shared, table, player_id)) reactor_prompt(r, table);
+            if (msg.type == MSG_ROLL) continue;
+        }
+
+        if (msg.type == MSG_ROLL) reactor_roll(r, table_id, player_id);
+        else if (msg.type == MSG_HELLO) set_player_name(table, player_id, msg);
+        else if (msg.type == MSG_SHM_VIEW) set_shm_view(table, player_id, true);
+    }
+    if (reader.error) reader.reset();
+}
+
+void reactor_handle_timer(Reactor* r) {
+    uint64_t expirations;
+    read(r->timer_fd, &expirations, sizeof(expirations));
+
+    long long now = monotonic_ns();
+    while (!r->pending_resets.empty() && r->pending_resets.front().first <= now) {
+        Table* table = get_table(r->pending_resets.front().second);
+        r->pending_resets.pop_front();
+        reset_game(r->shared, table);
+        reactor_prompt(r, table);
+    }
+    while (!r->deadlines.empty() && r->deadlines.front().at <= now) {
+        TurnDeadline expired = r->deadlines.front();
+        r->deadlines.pop_front();
+        if (expired.prompt == r->prompts[expired.table_id / r->count])
+            reactor_deadline(r, expired.table_id);
+    }
+    reactor_arm_timer(r);
+}
+
+void* reactor_thread(void* arg) {
+    Reactor* r = static_cast<Reactor*>(arg);
+    SharedData* shared = r->shared;
+
+    metrics_attach(g_metrics, "reactor");
+    char trace_name[TRACE_NAME_LEN];
+    snprintf(trace_name, sizeof(trace_name), "reactor %d", r->index);
+    trace_attach(trace_name);
+
+    r->epoll_fd = epoll_create1(0);
+    r->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    if (r->epoll_fd < 0 || r->timer_fd < 0) {
+        perror("reactor epoll/timerfd");
+        return nullptr;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = REACTOR_TIMER_KEY;
+    epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, r->timer_fd, &ev);
+    ev.data.u64 = REACTOR_INBOX_KEY;
+    epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, r->inbox_fd, &ev);
+
+    // Open and register every seat of every owned FIFO table
+    int owned = (r->fifo_tables - r->index + r->count - 1) / r->count;
+    r->fd_in.assign(owned * MAX_PLAYERS, -1);
+    r->readers.resize(owned * MAX_PLAYERS);
+    r->sessions.resize(owned * MAX_PLAYERS);
+    r->late_rolls.resize(owned * MAX_PLAYERS);
+    r->channels.resize(owned);
+    r->prompts.resize(owned);
+
+    for (int t = r->index; t < r->fifo_tables; t += r->count) {
+        Table* table = get_table(t);
+        if (!channel_open(&reactor_channel(r, t), t, table->game.num_players)) {
+            perror("FIFO open in reactor");
+            return nullptr;
+        }
+
+        for (int i = 0; i < table->game.num_players; i++) {
+            int& fd_in = reactor_fd_in(r, t, i);
+            fd_in = open(fifo_path(t, i, "in").c_str(), O_RDWR | O_NONBLOCK);
+            if (fd_in < 0) {
+                perror("FIFO open in reactor");
+                return nullptr;
+            }
+
+            ev.data.u64 = static_cast<uint64_t>(t) * MAX_PLAYERS + i;
+            epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, fd_in, &ev);
+
+            seat_player(shared, table, i);
+        }
+        reactor_prompt(r, table);
+    }
+
+    std::cout << "[SERVER] Reactor " << r->index << " started (" << owned << " tables)\n";
+
+    epoll_event events[64];
+    while (true) {
+        int n = epoll_wait(r->epoll_fd, events, 64, -1);
+        for (int e = 0; e < n; e++) {
+            uint64_t key = events[e].data.u64;
+            if (key == REACTOR_TIMER_KEY)
+                reactor_handle_timer(r);
+            else if (key == REACTOR_INBOX_KEY)
+                reactor_handle_inbox(r);
+            else if (key & REACTOR_OUT_KEY)
+                reactor_handle_output(r, (key & ~REACTOR_OUT_KEY) / MAX_PLAYERS,
+                                      (key & ~REACTOR_OUT_KEY) % MAX_PLAYERS);
+            else {
+                // A socket seat: one registration for both directions
+                if (events[e].events & EPOLLOUT)
+                    reactor_handle_output(r, key / MAX_PLAYERS, key % MAX_PLAYERS);
+                if (events[e].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                    reactor_handle_input(r, key / MAX_PLAYERS, key % MAX_PLAYERS);
+            }
+            if (!r->stuck_tables.empty()) reactor_unstick(r);
+        }
+
+        // Stopping for a warm restart: every event taken was played in full
+        if (g_stopping.load(std::memory_order_acquire)) break;
+    }
+
+    return nullptr;
+}
+
+/* ========================================
+   PLAYER LISTENER - Dynamic Seats over SOCK_SEQPACKET
+   ======================================== */
+
+// Players who connect to PLAYER_SOCKET are given a seat instead of picking
+// one. The listener thread accepts, waits for MSG_JOIN and seats the player:
+//   1. back in the seat their name holds in a running game (reconnect)
+//   2. else in a socket table that is still waiting for players
+//   3. else at a new socket table
+// It answers MSG_WELCOME and hands the socket to the reactor owning the
+// table, which plays it like a FIFO seat. Seats of players who leave are
+// kept for their name until the game ends, then freed for newcomers.
+constexpr uint64_t LISTENER_LISTEN_KEY = ~0ULL;
+
+struct PlayerListener {
+    SharedData* shared;
+    std::vector<Reactor>* reactors;
+    int num_players;
+    int epoll_fd;
+    int listen_fd;
+    std::unordered_map<int, MsgReader<256>> joining;   // accepted, no MSG_JOIN yet
+    std::vector<int> tables;                            // socket tables, oldest first
+    std::unordered_map<std::string, int> last_table;    // name -> table it last sat at
+};
+
+struct Admission {
+    int table_id;
+    int player_id;
+    uint32_t session;
+    bool reconnected;
+    bool started;
+};
+
+// Seat the player at `table` if it has a seat for them. Only the listener
+// seats socket players, so a seat found free stays free until it is taken.
+// A reconnect finds the seat held under the name: reserved in a running
+// game, or still connected if the old socket's hangup is not processed
+// yet (the new connection then takes over).
+bool try_seat(SharedData* shared, Table* table, const char* name, bool reconnect,
+              Admission* out) {
+    lock_table(table);
+
+    int seat = -1;
+    bool running = table->game.game_active || table->game.game_over;
+    for (int i = 0; i < table->game.num_players && seat < 0; i++) {
+        const Player& player = table->players[i];
+        if (reconnect ? (player.connected || running) && strcmp(player.name, name) == 0
+                      : !player.connected && !running)
+            seat = i;
+    }
+
+    if (seat >= 0) {
+        Player& player = table->players[seat];
+        if (name[0]) strncpy(player.name, name, MAX_NAME_LEN - 1);
+        log_ring_push(&shared->log_ring, "Table %d: Player %d (%s) %s", table->id, seat,
+                      player.name, reconnect ? "reconnected" : "joined");
+        log_event(shared, table, table->game_number, EV_JOIN, seat, reconnect);
+
+        out->table_id = table->id;
+        out->player_id = seat;
+        out->reconnected = reconnect;
+        out->started = false;
+        if (player.connected)
+            set_shm_view_locked(table, seat, false);   // the new client asks again if it wants it
+        else
+            out->started = seat_player_locked(shared, table, seat);
+        out->session = ++player.session;
+    }
+
+    pthread_mutex_unlock(&table->game_mutex);
+    if (seat >= 0 && out->started) print_game_started(table);
+    return seat >= 0;
+}
+
+bool admit_player(PlayerListener* l, const char* name, Admission* out) {
+    if (name[0]) {
+        auto it = l->last_table.find(name);
+        if (it != l->last_table.end() && try_seat(l->shared, get_table(it->second), name, true, out))
+            return true;
+    }
+
+    // Newest tables are the likeliest to be still filling up
+    for (auto it = l->tables.rbegin(); it != l->tables.rend(); ++it) {
+        if (try_seat(l->shared, get_table(*it), name, false, out)) return true;
+    }
+
+    Table* table = table_create(l->shared, l->num_players, true);
+    if (!table) return false;
+    l->tables.push_back(table->id);
+
+    log_ring_push(&l->shared->log_ring, "Table %d: created for socket players", table->id);
+    std::cout << "[SERVER] Table " << table->id << ": created for socket players\n";
+    return try_seat(l->shared, table, name, false, out);
+}
+
+// MSG_JOIN: seat the player, welcome them and pass the socket on
+void listener_join(PlayerListener* l, int fd, const MsgView& msg) {
+    long long start = monotonic_ns();
+
+    char name[MAX_NAME_LEN] = {};
+    Admission seat;
+    bool valid = msg.length < MAX_NAME_LEN;
+    if (valid) std::memcpy(name, msg.payload, msg.length);
+    if (!valid || (name[0] && !score_name_valid(name)) || !admit_player(l, name, &seat)) {
+        close(fd);
+        return;
+    }
+    if (name[0]) l->last_table[name] = seat.table_id;
+
+    WelcomeMsg welcome;
+    welcome.table_id = seat.table_id;
+    welcome.player_id = seat.player_id;
+    welcome.num_players = l->num_players;
+    welcome.reconnected = seat.reconnected;
+    send_msg(fd, MSG_WELCOME, &welcome, sizeof(welcome));
+
+    Reactor& r = (*l->reactors)[seat.table_id % l->reactors->size()];
+    pthread_mutex_lock(&r.inbox_mutex);
+    r.inbox.push_back({seat.table_id, seat.player_id, fd, seat.session, seat.started});
+    pthread_mutex_unlock(&r.inbox_mutex);
+    uint64_t one = 1;
+    write(r.inbox_fd, &one, sizeof(one));
+
+    metric_add(seat.reconnected ? &t_metrics->socket_rejoins : &t_metrics->socket_joins);
+    metric_record(&t_metrics->admission, monotonic_ns() - start);
+}
+
+void listener_accept(PlayerListener* l) {
+    while (true) {
+        int fd = accept4(l->listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+
+        l->joining[fd].reset();
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = fd;
+        epoll_ctl(l->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+void listener_handle(PlayerListener* l, int fd) {
+    auto it = l->joining.find(fd);
+    if (it == l->joining.end()) return;
+    MsgReader<256>& reader = it->second;
+
+    ssize_t n = reader.fill(fd);
+    if (n < 0 && errno == EAGAIN) return;
+
+    MsgView msg;
+    bool joined = n > 0 && reader.next(msg) && msg.type == MSG_JOIN;
+
+    // Either way the socket leaves the listener: to a reactor, or closed.
+    // Anything sent after MSG_JOIN stays queued in the socket for the reactor.
+    epoll_ctl(l->epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    l->joining.erase(it);
+    if (joined) listener_join(l, fd, msg);
+    else close(fd);
+}
+
+int player_listen() {
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, PLAYER_SOCKET, sizeof(addr.sun_path) - 1);
+    unlink(PLAYER_SOCKET);
+
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(fd, SOMAXCONN) < 0) {
+        close(fd);
+        return -1;
+    }
+    chmod(PLAYER_SOCKET, 0666);
+    return fd;
+}
+
+void* listener_thread(void* arg) {
+    PlayerListener* l = static_cast<PlayerListener*>(arg);
+    l->listen_fd = player_listen();
+    l->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (l->listen_fd < 0 || l->epoll_fd < 0) {
+        perror("player socket");
+        return nullptr;
+    }
+
+    metrics_attach(g_metrics, "listener");
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = LISTENER_LISTEN_KEY;
+    epoll_ctl(l->epoll_fd, EPOLL_CTL_ADD, l->listen_fd, &ev);
+
+    std::cout << "[SERVER] Players can join at " << PLAYER_SOCKET << "\n";
+
+    epoll_event events[64];
+    while (true) {
+        int n = epoll_wait(l->epoll_fd, events, 64, -1);
+        for (int e = 0; e < n; e++) {
+            uint64_t key = events[e].data.u64;
+            if (key == LISTENER_LISTEN_KEY)
+                listener_accept(l);
+            else
+                listener_handle(l, static_cast<int>(key));
+        }
+    }
+
+    return nullptr;
+}
+
+// Start one thread per reactor; the first fifo_tables tables are FIFO
+// tables and are split between them, socket tables arrive later
+bool start_reactors(SharedData* shared, std::vector<Reactor>* reactors, int fifo_tables) {
+    int count = static_cast<int>(reactors->size());
+    for (int i = 0; i < count; i++) {
+        Reactor& r = (*reactors)[i];
+        r.shared = shared;
+        r.index = i;
+        r.count = count;
+        r.fifo_tables = fifo_tables;
+        r.inbox_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        if (r.inbox_fd < 0 || pthread_create(&r.thread, nullptr, reactor_thread, &r) != 0) {
+            perror("pthread_create reactor");
+            return false;
+        }
+    }
+    return true;
+}
+
+// Socket tables are played by reactors: the reactor-mode ones, or in fork
+// mode one reactor started for them alone.
+// After a warm restart the socket tables in the segment are handed out
+// again before new ones are made. last_table starts empty: resume_table()
+// ended their games like everyone leaving, so no seat is held for a name.
+bool start_player_listener(SharedData* shared, std::vector<Reactor>* reactors,
+                           int num_players) {
+    static PlayerListener listener;
+    listener.shared = shared;
+    listener.reactors = reactors;
+    listener.num_players = num_players;
+    for (int t = 0; t < shared->num_tables; t++)
+        if (get_table(t)->dynamic) listener.tables.push_back(t);
+
+    pthread_t thread;
+    if (pthread_create(&thread, nullptr, listener_thread, &listener) != 0) {
+        perror("pthread_create listener");
+        return false;
+    }
+    return true;
+}
+
+/* ========================================
+   SPECTATORS - Coalesced Read-Only Views
+   ======================================== */
+
+// Viewers attach to SPECTATOR_SOCKET at any time and never hold a seat.
+// One spectator thread serves them all without touching the turn path:
+// every tick it snapshots the watched tables (seqlock, no game_mutex),
+// renders each changed table once and offers that frame to its viewers.
+// A viewer has at most one frame in flight, so one that cannot keep up
+// skips to the newest state instead of building a backlog.
+constexpr int SPECTATOR_TICK_MS = 20;
+constexpr int MAX_SPECTATORS = 4096;
+constexpr uint64_t SPECTATOR_LISTEN_KEY = ~0ULL;
+constexpr uint64_t SPECTATOR_TIMER_KEY = ~0ULL - 1;
+
+struct Viewer {
+    int fd;
+    int table_id = -1;
+    bool sent_any = false;
+    uint32_t sent_version = 0;   // version of the last frame handed to the socket
+    std::string pending;         // unsent tail of the frame in flight
+    bool want_out = false;       // EPOLLOUT armed
+    MsgReader<64> reader;
+};
+
+struct TableView {
+    bool rendered = false;
+    uint32_t version = 0;
+    std::string frame;           // latest MSG_SNAPSHOT, rendered once per change
+    std::vector<int> viewers;    // viewer fds watching this table
+};
+
+struct SpectatorHub {
+    SharedData* shared;
+    int epoll_fd;
+    int listen_fd;
+    int timer_fd;
+    std::unordered_map<int, Viewer> viewers;    // by fd
+    std::unordered_map<int, TableView> views;   // by table id, watched tables only
+};
+
+// Render the table's current state if it changed since the last frame
+void spectator_refresh(int table_id, TableView* view) {
+    GameState state;
+    uint32_t version = table_snapshot(get_table(table_id), &state);
+    if (view->rendered && version == view->version) return;
+
+    SnapshotMsg snap;
+    snap.table_id = table_id;
+    snap.version = version / 2;
+    snap.current_turn = state.current_turn;
+    snap.winner = state.winner;
+    snap.game_active = state.game_active;
+    snap.num_players = state.num_players;
+
+    std::string_view track = t_track.render(state.positions, state.num_players);
+    uint32_t length = sizeof(snap) + state.num_players * sizeof(int32_t) + track.size();
+    MsgHeader hdr = make_header(MSG_SNAPSHOT, length);
+
+    view->frame.clear();
+    view->frame.append(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    view->frame.append(reinterpret_cast<const char*>(&snap), sizeof(snap));
+    view->frame.append(reinterpret_cast<const char*>(state.positions),
+                       state.num_players * sizeof(int32_t));
+    view->frame.append(track.data(), track.size());
+
+    view->version = version;
+    view->rendered = true;
+}
+
+void spectator_drop(SpectatorHub* hub, int fd) {
+    auto it = hub->viewers.find(fd);
+    if (it == hub->viewers.end()) return;
+
+    auto view = hub->views.find(it->second.table_id);
+    if (view != hub->views.end()) {
+        std::vector<int>& list = view->second.viewers;
+        list.erase(std::remove(list.begin(), list.end(), fd), list.end());
+        if (list.empty()) hub->views.erase(view);
+    }
+
+    close(fd);
+    hub->viewers.erase(it);
+    metric_set(&t_metrics->spectators, hub->viewers.size());
+}
+
+// Write as much of `data` as the socket takes; keep the rest in flight.
+// Returns false if the viewer is gone.
+bool spectator_write(SpectatorHub* hub, Viewer* viewer, const char* data, size_t len) {
+    ssize_t n = send(viewer->fd, data, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) return false;
+        n = 0;
+    }
+    metric_add(&t_metrics->spectator_bytes, n);
+
+    viewer->pending.assign(data + n, len - n);
+
+    // Only ask for EPOLLOUT while something is in flight
+    bool want_out = !viewer->pending.empty();
+    if (want_out != viewer->want_out) {
+        epoll_event ev{};
+        ev.events = EPOLLIN | (want_out ? uint32_t(EPOLLOUT) : 0u);
+        ev.data.u64 = viewer->fd;
+        epoll_ctl(hub->epoll_fd, EPOLL_CTL_MOD, viewer->fd, &ev);
+        viewer->want_out = want_out;
+    }
+    return true;
+}
+
+// Hand the viewer its table's newest frame unless it already has it or
+// is still busy with an older one (it gets the newest once that drains)
+bool spectator_offer(SpectatorHub* hub, Viewer* viewer) {
+    auto it = hub->views.find(viewer->table_id);
+    if (it == hub->views.end()) return true;
+    TableView& view = it->second;
+
+    if (viewer->sent_any && viewer->sent_version == view.version) return true;
+    if (!viewer->pending.empty()) {
+        metric_add(&t_metrics->spectator_coalesced);
+        return true;
+    }
+
+    viewer->sent_any = true;
+    viewer->sent_version = view.version;
+    metric_add(&t_metrics->spectator_frames);
+    return spectator_write(hub, viewer, view.frame.data(), view.frame.size());
+}
+
+void spectator_accept(SpectatorHub* hub) {
+    while (true) {
+        int fd = accept4(hub->listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+
+        if (static_cast<int>(hub->viewers.size()) >= MAX_SPECTATORS) {
+            close(fd);
+            continue;
+        }
+
+        Viewer& viewer = hub->viewers[fd];
+        viewer.fd = fd;
+
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = fd;
+        epoll_ctl(hub->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+        metric_set(&t_metrics->spectators, hub->viewers.size());
+    }
+}
+
+// MSG_WATCH: move the viewer to another table and send its state at once
+bool spectator_watch(SpectatorHub* hub, Viewer* viewer, const MsgView& msg) {
+    WatchMsg watch;
+    if (msg.length < sizeof(watch)) return false;
+    std::memcpy(&watch, msg.payload, sizeof(watch));
+    if (watch.table_id < 0 || watch.table_id >= hub->shared->num_tables) return false;
+
+    auto old_view = hub->views.find(viewer->table_id);
+    if (old_view != hub->views.end()) {
+        std::vector<int>& list = old_view->second.viewers;
+        list.erase(std::remove(list.begin(), list.end(), viewer->fd), list.end());
+        if (list.empty()) hub->views.erase(old_view);
+    }
+
+    TableView& view = hub->views[watch.table_id];
+    view.viewers.push_back(viewer->fd);
+    viewer->table_id = watch.table_id;
+    viewer->sent_any = false;
+
+    spectator_refresh(watch.table_id, &view);
+    return spectator_offer(hub, viewer);
+}
+
+void spectator_handle(SpectatorHub* hub, int fd, uint32_t events) {
+    auto it = hub->viewers.find(fd);
+    if (it == hub->viewers.end()) return;
+    Viewer* viewer = &it->second;
+
+    if (events & EPOLLOUT) {
+        std::string rest;
+        rest.swap(viewer->pending);
+        if (!spectator_write(hub, viewer, rest.data(), rest.size()) ||
+            (viewer->pending.empty() && !spectator_offer(hub, viewer))) {
+            spectator_drop(hub, fd);
+            return;
+        }
+    }
+
+    if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+        if (viewer->reader.fill(fd) <= 0) {
+            spectator_drop(hub, fd);
+            return;
+        }
+
+        MsgView msg;
+        while (viewer->reader.next(msg)) {
+            if (msg.type == MSG_WATCH && !spectator_watch(hub, viewer, msg)) {
+                spectator_drop(hub, fd);
+                return;
+            }
+        }
+        if (viewer->reader.error) spectator_drop(hub, fd);
+    }
+}
+
+// Every tick: one snapshot and at most one render per watched table
+void spectator_tick(SpectatorHub* hub) {
+    uint64_t expirations;
+    read(hub->timer_fd, &expirations, sizeof(expirations));
+
+    std::vector<int> gone;
+    for (auto& entry : hub->views) {
+        TableView& view = entry.second;
+        uint32_t before = view.version;
+        spectator_refresh(entry.first, &view);
+        if (view.version == before) continue;
+
+        for (int fd : view.viewers) {
+            if (!spectator_offer(hub, &hub->viewers[fd])) gone.push_back(fd);
+        }
+    }
+    for (int fd : gone) spectator_drop(hub, fd);
+}
+
+int spectator_listen() {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, SPECTATOR_SOCKET, sizeof(addr.sun_path) - 1);
+    unlink(SPECTATOR_SOCKET);
+
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(fd, SOMAXCONN) < 0) {
+        close(fd);
+        return -1;
+    }
+    chmod(SPECTATOR_SOCKET, 0666);
+    return fd;
+}
+
+void* spectator_thread(void* arg) {
+    SpectatorHub hub;
+    hub.shared = static_cast<SharedData*>(arg);
+    hub.listen_fd = spectator_listen();
+    hub.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    hub.timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (hub.listen_fd < 0 || hub.epoll_fd < 0 || hub.timer_fd < 0) {
+        perror("spectator socket");
+        return nullptr;
+    }
+
+    metrics_attach(g_metrics, "spectator");
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = SPECTATOR_LISTEN_KEY;
+    epoll_ctl(hub.epoll_fd, EPOLL_CTL_ADD, hub.listen_fd, &ev);
+    ev.data.u64 = SPECTATOR_TIMER_KEY;
+    epoll_ctl(hub.epoll_fd, EPOLL_CTL_ADD, hub.timer_fd, &ev);
+
+    itimerspec its{};
+    its.it_interval.tv_nsec = SPECTATOR_TICK_MS * 1000000L;
+    its.it_value = its.it_interval;
+    timerfd_settime(hub.timer_fd, 0, &its, nullptr);
+
+    std::cout << "[SERVER] Spectators can attach at " << SPECTATOR_SOCKET << "\n";
+
+    epoll_event events[64];
+    while (true) {
+        int n = epoll_wait(hub.epoll_fd, events, 64, -1);
+        for (int e = 0; e < n; e++) {
+            uint64_t key = events[e].data.u64;
+            if (key == SPECTATOR_LISTEN_KEY)
+                spectator_accept(&hub);
+            else if (key == SPECTATOR_TIMER_KEY)
+                spectator_tick(&hub);
+            else
+                spectator_handle(&hub, static_cast<int>(key), events[e].events);
+        }
+    }
+
+    return nullptr;
+}
+
+/* ========================================
+   WARM RESTART - Stop and Resume over Shared Memory
+   ======================================== */
+
+// A server stopped with SIGTERM (or one that died) leaves the control and
+// table segments and the FIFOs in place. `server -R` checks the segment
+// header, stops whatever is left of the previous server, brings every
+// table to a resumable state and starts threads and handlers on it.
+// FIFO players keep their connections and never notice.
+
+// SIGTERM: reactors finish the events in hand, handlers exit at their
+// next wait. Afterwards no roll is half done.
+void stop_workers() {
+    g_stopping.store(true, std::memory_order_release);
+    if (g_reactors) {
+        for (Reactor& r : *g_reactors) {
+            uint64_t one = 1;
+            write(r.inbox_fd, &one, sizeof(one));
+        }
+        for (Reactor& r : *g_reactors) pthread_join(r.thread, nullptr);
+    }
+    if (g_handlers) {
+        for (pid_t pid : *g_handlers) if (pid > 0) kill(pid, SIGTERM);
+        for (pid_t pid : *g_handlers) if (pid > 0) waitpid(pid, nullptr, 0);
+    }
+}
+
+// Is `pid` alive and running this program? Pids recorded by a previous
+// server may have been reused since.
+bool is_server_process(pid_t pid) {
+    if (pid <= 0 || pid == getpid()) return false;
+
+    char path[64], comm[32] = {}, own[32] = {};
+    snprintf(path, sizeof(path), "/proc/%d/comm", pid);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    read(fd, comm, sizeof(comm) - 1);
+    close(fd);
+
+    fd = open("/proc/self/comm", O_RDONLY);
+    if (fd < 0) return false;
+    read(fd, own, sizeof(own) - 1);
+    close(fd);
+    return strcmp(comm, own) == 0;
+}
+
+// SIGTERM a process left by the previous server and wait for it to exit.
+// Returns false if it was still running after timeout_ms.
+bool stop_process(pid_t pid, int timeout_ms) {
+    if (!is_server_process(pid)) return true;
+    int pidfd = syscall(SYS_pidfd_open, pid, 0);
+    if (pidfd < 0) return true;
+
+    syscall(SYS_pidfd_send_signal, pidfd, SIGTERM, nullptr, 0);
+    pollfd pfd = { pidfd, POLLIN, 0 };
+    bool exited = poll(&pfd, 1, timeout_ms) > 0;
+    close(pidfd);
+    return exited;
+}
+
+// Check the segment header and stop the previous server if it still runs
+bool resume_check(SharedData* shared) {
+    if (shared->magic != SHM_MAGIC || shared->version != SHM_VERSION ||
+        shared->shared_size != sizeof(SharedData) || shared->table_size != sizeof(Table)) {
+        std::cerr << "[SERVER] Shared memory is from an incompatible server build"
+                  << " (version " << shared->version << ", expected " << SHM_VERSION
+                  << "); start without -R\n";
+        return false;
+    }
+
+    if (!stop_process(shared->server_pid, 10000)) {
+        std::cerr << "[SERVER] Previous server " << shared->server_pid << " did not stop\n";
+        return false;
+    }
+    return true;
+}
+
+// Handlers outlive a server that died instead of stopping; stop them too
+void stop_stray_handlers(SharedData* shared) {
+    for (int t = 0; t < shared->fifo_tables; t++) {
+        for (int i = 0; i < shared->num_players; i++) {
+            Player& player = get_table(t)->players[i];
+            if (!stop_process(player.handler_pid, 1000)) kill(player.handler_pid, SIGKILL);
+            player.handler_pid = 0;
+        }
+    }
+}
+
+// Bring one table to a state the new threads and handlers pick up from.
+// Taking the lock repairs the table if the old server died holding it.
+void resume_table(SharedData* shared, Table* table) {
+    lock_table(table);
+
+    bool reset = false;
+    if (table->dynamic) {
+        // Socket connections ended with the old server; the players rejoin
+        // and the table waits for them like after everyone left
+        state_write_begin(table);
+        for (int i = 0; i < table->game.num_players; i++) {
+            set_seat_connected(table, i, false);
+            table->players[i].shm_view = 0;
+            table->players[i].missed_turns = 0;
+            table->players[i].session++;
+        }
+        table->game.active_players = 0;
+        state_write_end(table);
+        table->state_watchers = 0;
+        reset = true;
+    } else if (table->game.game_over) {
+        reset = true;   // the pause before the next game was the old server's timer
+    } else if (table->game.game_active && table->game.turn_complete) {
+        advance_turn(table);   // a roll the old scheduler never moved on from
+        turn_wake(table);
+    }
+
+    pthread_mutex_unlock(&table->game_mutex);
+    if (reset) reset_game(shared, table);
+}
+
+/* ========================================
+   MAIN SERVER
+   ======================================== */
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [-t tables] [-p players per table] [-r reactors]"
+              << " [-g pause ms] [-d deadline ms] [-a] [-i misses] [-s dice seed] [-R]"
+              << " [-T trace.json]\n"
+              << "  -r 0 (default) forks one handler process per player\n"
+              << "  -r N multiplexes all players over N epoll reactor threads\n"
+              << "  -g pause between games in milliseconds (default 3000)\n"
+              << "  -d turn deadline in milliseconds (default 30000, 0 = wait forever)\n"
+              << "  -a roll for a player who misses the deadline (default: skip the turn)\n"
+              << "  -i missed deadlines in a row before a seat goes idle (default 3, 0 = never)\n"
+              << "  -s master dice seed (default random, printed at startup)\n"
+              << "  -R resume the games a server stopped with SIGTERM left in shared memory\n"
+              << "     (tables, players and seed are taken from there)\n"
+              << "  -T record turn spans and write them to this file (Chrome trace JSON)\n"
+              << "     on shutdown and on SIGUSR1\n";
+}
+
+int main(int argc, char* argv[]) {
+    g_server_pid = getpid();
+
+    /* ---------- COMMAND LINE ---------- */
+    int num_tables = 1;
+    int num_players = 0;
+    int num_reactors = 0;
+    int pause_ms = 3000;
+    int deadline_ms = 30000;
+    bool deadline_roll = false;
+    int idle_after = 3;
+    bool resume = false;
+    uint64_t dice_seed = std::random_device{}() * 0x100000000ULL ^ std::random_device{}();
+    int opt;
+    while ((opt = getopt(argc, argv, "t:p:r:g:d:ai:s:RT:")) != -1) {
+        switch (opt) {
+        case 't': num_tables = atoi(optarg); break;
+        case 'p': num_players = atoi(optarg); break;
+        case 'r': num_reactors = atoi(optarg); break;
+        case 'g': pause_ms = atoi(optarg); break;
+        case 'd': deadline_ms = atoi(optarg); break;
+        case 'a': deadline_roll = true; break;
+        case 'i': idle_after = atoi(optarg); break;
+        case 's': dice_seed = strtoull(optarg, nullptr, 0); break;
+        case 'R': resume = true; break;
+        case 'T': g_trace_path = optarg; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+
+    // -R without state left behind is an ordinary start
+    int shm_fd = -1;
+    if (resume) {
+        struct stat st{};
+        shm_fd = shm_open(SHM_NAME, O_RDWR, 0);
+        if (shm_fd < 0 || fstat(shm_fd, &st) < 0 ||
+            st.st_size < static_cast<off_t>(sizeof(SharedData))) {
+            std::cout << "[SERVER] No game state to resume, starting fresh\n";
+            if (shm_fd >= 0) close(shm_fd);
+            resume = false;
+        }
+    }
+
+    if (num_tables < 1 || num_tables > MAX_TABLES) {
+        std::cerr << "Error: Must be 1-" << MAX_TABLES << " tables\n";
+        return 1;
+    }
+
+    if (pause_ms < 0) {
+        std::cerr << "Error: Pause between games must be >= 0 ms\n";
+        return 1;
+    }
+
+    if (deadline_ms < 0 || idle_after < 0) {
+        std::cerr << "Error: Turn deadline and idle misses must be >= 0\n";
+        return 1;
+    }
+
+    /* ---------- GET NUMBER OF PLAYERS ---------- */
+    if (num_players == 0 && !resume) {
+        std::cout << "Enter number of players (3-" << MAX_PLAYERS << "): ";
+        std::cin >> num_players;
+    }
+
+    if (!resume && (num_players < 3 || num_players > MAX_PLAYERS)) {
+        std::cerr << "Error: Must be 3-" << MAX_PLAYERS << " players (build with make SEATS=n"
+                  << " for larger tables)\n";
+        return 1;
+    }
+
+    /* ---------- SIGNAL HANDLERS ---------- */
+    struct sigaction sa{};
+    sa.sa_handler = sigchld_handler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGCHLD, &sa, nullptr);
+
+    // ========================================
+    // Register SIGINT handler
+    // ========================================
+    signal(SIGINT, sigint_handler);
+    signal(SIGTERM, sigterm_handler);
+    signal(SIGUSR1, sigusr1_handler);
+
+    // Socket players can hang up mid-write; that is a disconnect, not a crash
+    signal(SIGPIPE, SIG_IGN);
+
+    /* ---------- SHARED MEMORY ---------- */
+    if (!resume) {
+        shm_unlink(SHM_NAME);
+        shm_fd = shm_open(SHM_NAME, O_CREAT | O_RDWR, 0666);
+        if (shm_fd < 0) {
+            perror("shm_open");
+            return 1;
+        }
+
+        ftruncate(shm_fd, sizeof(SharedData));
+    }
+
+    SharedData* shared = static_cast<SharedData*>(
+        mmap(nullptr, sizeof(SharedData),
+             PROT_READ | PROT_WRITE,
+             MAP_SHARED, shm_fd, 0)
+    );
+
+    if (shared == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+
+    if (resume) {
+        // Tables, players and dice seed continue from the stopped server
+        if (!resume_check(shared)) return 1;
+        num_tables = shared->fifo_tables;
+        num_players = shared->num_players;
+        dice_seed = shared->dice_seed;
+    } else {
+        std::memset(static_cast<void*>(shared), 0, sizeof(SharedData));
+    }
+
+    if (num_reactors < 0 || num_reactors > num_tables) {
+        std::cerr << "Error: Must be 0-" << num_tables << " reactors\n";
+        return 1;
+    }
+
+    // ========================================
+    // Set global pointer for signal handler
+    // ========================================
+    g_shared = shared;
+    shared->game_pause_ns = pause_ms * 1000000LL;
+    shared->turn_deadline_ns = deadline_ms * 1000000LL;
+    shared->deadline_roll = deadline_roll;
+    shared->idle_after = idle_after;
+    shared->dice_seed = dice_seed;
+
+    /* ---------- TABLE SEGMENT ---------- */
+    // Reserve address space for MAX_TABLES now; the backing object starts
+    // empty and table_create() grows it with ftruncate as tables are added.
+    if (!resume) shm_unlink(TABLES_SHM_NAME);
+    g_tables_fd = shm_open(TABLES_SHM_NAME, resume ? O_RDWR : O_CREAT | O_RDWR, 0666);
+    if (g_tables_fd < 0) {
+        perror("shm_open tables");
+        return 1;
+    }
+
+    void* tables = mmap(nullptr, sizeof(Table) * MAX_TABLES,
+                        PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_NORESERVE, g_tables_fd, 0);
+    if (tables == MAP_FAILED) {
+        perror("mmap tables");
+        return 1;
+    }
+    g_tables = static_cast<Table*>(tables);
+    if (resume) stop_stray_handlers(shared);
+
+    /* ---------- METRICS SEGMENT ---------- */
+    shm_unlink(METRICS_SHM_NAME);
+    int metrics_fd = shm_open(METRICS_SHM_NAME, O_CREAT | O_RDWR, 0644);
+    if (metrics_fd < 0) {
+        perror("shm_open metrics");
+        return 1;
+    }
+
+    // Sparse: pages are only allocated for slots that get used
+    ftruncate(metrics_fd, sizeof(MetricsBlock));
+    void* metrics = mmap(nullptr, sizeof(MetricsBlock), PROT_READ | PROT_WRITE,
+                         MAP_SHARED, metrics_fd, 0);
+    if (metrics == MAP_FAILED) {
+        perror("mmap metrics");
+        return 1;
+    }
+    close(metrics_fd);
+
+    g_metrics = static_cast<MetricsBlock*>(metrics);
+    g_metrics->magic = METRICS_MAGIC;
+    g_metrics->version = METRICS_VERSION;
+    g_metrics->start_ns = monotonic_ns();
+
+    /* ---------- TRACE SEGMENT (-T) ---------- */
+    shm_unlink(TRACE_SHM_NAME);
+    if (!g_trace_path.empty()) {
+        int trace_fd = shm_open(TRACE_SHM_NAME, O_CREAT | O_RDWR, 0644);
+        if (trace_fd < 0) {
+            perror("shm_open trace");
+            return 1;
+        }
+
+        // Sparse like the metrics: only buffers that get used take memory
+        ftruncate(trace_fd, sizeof(TraceBlock));
+        void* trace = mmap(nullptr, sizeof(TraceBlock), PROT_READ | PROT_WRITE,
+                           MAP_SHARED, trace_fd, 0);
+        if (trace == MAP_FAILED) {
+            perror("mmap trace");
+            return 1;
+        }
+        close(trace_fd);
+
+        g_trace = static_cast<TraceBlock*>(trace);
+        g_trace->magic = TRACE_MAGIC;
+        g_trace->version = TRACE_VERSION;
+        g_trace->start_ns = monotonic_ns();
+        g_trace->server_pid = g_server_pid;
+        std::cout << "[SERVER] Tracing turns to " << g_trace_path << " (SIGUSR1 writes it now)\n";
+    }
+
+    /* ---------- PROCESS-SHARED SYNC INIT ---------- */
+    // Only server threads take these, so after a restart nobody else can
+    // hold them; table locks and queued wins and log lines are kept
+    init_shared_mutex(&shared->log_mutex);
+    init_shared_mutex(&shared->score_mutex);
+    init_shared_mutex(&shared->table_mutex);
+
+    sem_init(&shared->sched_sem, 1, 0);
+    shared->sched_queue.init();
+    sem_init(&shared->score_sem, 1, resume ? 1 : 0);
+    if (!resume) shared->score_queue.init();
+    if (!resume) shared->event_queue.init();
+
+    /* ---------- INITIALIZE GAME STATE ---------- */
+    if (resume) {
+        for (int t = 0; t < shared->num_tables; t++) resume_table(shared, get_table(t));
+        shared->restarts++;
+    } else {
+        for (int t = 0; t < num_tables; t++) {
+            if (!table_create(shared, num_players)) return 1;
+        }
+        log_ring_init(&shared->log_ring);
+
+        shared->num_players = num_players;
+        shared->fifo_tables = num_tables;
+        shared->shared_size = sizeof(SharedData);
+        shared->table_size = sizeof(Table);
+        shared->version = SHM_VERSION;
+        shared->magic = SHM_MAGIC;
+    }
+    shared->server_pid = g_server_pid;
+
+    if (!score_store_open(&g_scores)) return 1;
+    std::cout << "[SERVER] Scores loaded: " << g_scores.wins.size() << " player(s)\n";
+
+    /* ---------- LOGGER THREAD ---------- */
+    std::cout << "[SERVER] Dice master seed: 0x" << std::hex << dice_seed << std::dec << "\n";
+    if (resume) {
+        std::cout << "[SERVER] Warm restart #" << shared->restarts << ": resumed "
+                  << shared->num_tables << " table(s)\n";
+        log_ring_push(&shared->log_ring, "[SERVER] Warm restart #%d: resumed %d table(s)",
+                      shared->restarts, shared->num_tables);
+    } else {
+        log_ring_push(&shared->log_ring, "[SERVER] Dice master seed 0x%016llx",
+                      static_cast<unsigned long long>(dice_seed));
+    }
+
+    // Helper threads leave SIGINT to the main thread, so the shutdown
+    // handler can take log_mutex without interrupting the logger. SIGTERM
+    // and SIGCHLD too: the main thread stops, reaps and respawns handlers.
+    sigset_t block, old_mask;
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    sigaddset(&block, SIGTERM);
+    sigaddset(&block, SIGCHLD);
+    sigaddset(&block, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &block, &old_mask);
+
+    pthread_t logger;
+    if (pthread_create(&logger, nullptr, logger_thread, shared) != 0) {
+        perror("pthread_create logger");
+        return 1;
+    }
+
+    pthread_t scorekeeper;
+    if (pthread_create(&scorekeeper, nullptr, scorekeeper_thread, shared) != 0) {
+        perror("pthread_create scorekeeper");
+        return 1;
+    }
+
+    pthread_t spectator;
+    if (pthread_create(&spectator, nullptr, spectator_thread, shared) != 0) {
+        perror("pthread_create spectator");
+        return 1;
+    }
+
+    /* ---------- REACTOR MODE ---------- */
+    if (num_reactors > 0) {
+        std::vector<Reactor> reactors(num_reactors);
+        if (!start_reactors(shared, &reactors, num_tables) ||
+            !start_player_listener(shared, &reactors, num_players))
+            return 1;
+        g_reactors = &reactors;
+
+        pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
+
+        std::cout << "[SERVER] " << num_tables << " table(s) on " << num_reactors
+                  << " reactor thread(s). Running...\n";
+        std::cout << "[SERVER] Press Ctrl+C to shutdown gracefully\n";
+
+        // SIGUSR1 stays blocked except inside sigsuspend(), so a request
+        // is never taken between the check and the wait
+        sigset_t usr1;
+        sigemptyset(&usr1);
+        sigaddset(&usr1, SIGUSR1);
+        pthread_sigmask(SIG_BLOCK, &usr1, nullptr);
+        while (true) {
+            sigsuspend(&old_mask);
+            if (g_trace_requested) {
+                g_trace_requested = 0;
+                write_trace();
+            }
+        }
+    }
+
+    /* ---------- SCHEDULER THREAD ---------- */
+    pthread_t scheduler;
+    if (pthread_create(&scheduler, nullptr, scheduler_thread, shared) != 0) {
+        perror("pthread_create scheduler");
+        return 1;
+    }
+
+    pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
+
+    std::cout << "[SERVER] Waiting for " << num_players << " players on each of "
+              << num_tables << " table(s)...\n";
+
+    /* ---------- FORK PLAYER PROCESSES ---------- */
+    // One handler per seat, pid kept by seat index for crash recovery and
+    // warm restarts. A resumed seat whose player had left stays empty; an
+    // idle one gets a handler that waits for the player's input.
+    std::vector<pid_t> handlers(num_tables * num_players, -1);
+    g_handlers = &handlers;
+    for (int t = 0; t < num_tables; t++) {
+        for (int player_id = 0; player_id < num_players; player_id++) {
+            const Player& player = get_table(t)->players[player_id];
+            if (resume && !player.connected && !player.idle) continue;
+            pid_t pid = spawn_handler(shared, get_table(t), player_id, false);
+            if (pid < 0) return 1;
+            handlers[t * num_players + player_id] = pid;
+        }
+    }
+
+    /* ---------- PLAYER LISTENER ---------- */
+    // Started after the forks, so handlers never inherit player sockets
+    pthread_sigmask(SIG_BLOCK, &block, nullptr);
+    std::vector<Reactor> socket_reactor(1);
+    if (!start_reactors(shared, &socket_reactor, 0) ||
+        !start_player_listener(shared, &socket_reactor, num_players))
+        return 1;
+    g_reactors = &socket_reactor;
+    pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
+
+    /* ---------- PARENT WAITS ---------- */
+    // SIGCHLD stays blocked except inside sigsuspend(), so a handler that
+    // dies while the last one is being respawned is not missed (SIGUSR1
+    // too, so a trace request is not either)
+    std::cout << "[SERVER] All player processes forked. Running...\n";
+    std::cout << "[SERVER] Press Ctrl+C to shutdown gracefully\n";
+    metrics_attach(g_metrics, "supervisor");
+
+    sigset_t chld;
+    sigemptyset(&chld);
+    sigaddset(&chld, SIGCHLD);
+    sigaddset(&chld, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &chld, nullptr);
+    while (true) {
+        reap_handlers(shared, &handlers, num_players);
+        if (g_trace_requested) {
+            g_trace_requested = 0;
+            write_trace();
+        }
+        sigsuspend(&old_mask);
+    }
+
+    return 0;
+}
@@ -0,0 +1,224 @@
+#include <iostream>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common.hpp"
+#include "dice_rng.hpp"
+#include "race_rules.hpp"
+
+// Offline Monte Carlo of the dice race. Runs complete games with the
+// server's rules (race_rules.hpp) without a server: SIM_LANES games at a
+// time in one SIMD vector per seat, one batch loop per thread.
+
+/* ========================================
+   LANE TYPES - GCC Vector Extensions
+   ======================================== */
+constexpr int SIM_LANES = 8;   // 256-bit vectors of int32
+typedef int32_t Lanes __attribute__((vector_size(SIM_LANES * sizeof(int32_t))));
+typedef uint32_t ULanes __attribute__((vector_size(SIM_LANES * sizeof(uint32_t))));
+
+constexpr int MAX_SIM_TURNS = 4096;   // longer games are counted in the last bucket
+
+inline bool any_lane(Lanes mask) {
+    for (int i = 0; i < SIM_LANES; i++) if (mask[i]) return true;
+    return false;
+}
+
+inline bool all_lanes(Lanes mask) {
+    for (int i = 0; i < SIM_LANES; i++) if (!mask[i]) return false;
+    return true;
+}
+
+/* ========================================
+   LANE RNG - xoshiro128** per Lane
+   ======================================== */
+// One independent stream per lane, stepped together. The modulo bias of
+// 2^32 % 6 is below 1e-9, far under the simulation's sampling error.
+struct LaneRng {
+    ULanes s[4];
+};
+
+void lane_rng_seed(LaneRng* rng, uint64_t seed) {
+    for (int lane = 0; lane < SIM_LANES; lane++) {
+        uint64_t x = dice_mix(seed, lane);
+        for (int i = 0; i < 4; i++) rng->s[i][lane] = static_cast<uint32_t>(splitmix64(x));
+    }
+}
+
+inline ULanes rotl32(ULanes x, int k) {
+    return (x << k) | (x >> (32 - k));
+}
+
+inline Lanes lane_dice(LaneRng* rng) {
+    ULanes* s = rng->s;
+    ULanes result = rotl32(s[1] * 5, 7) * 9;
+    ULanes t = s[1] << 9;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl32(s[3], 11);
+    return reinterpret_cast<Lanes>(result % 6 + 1);
+}
+
+/* ========================================
+   SIMULATION
+   ======================================== */
+struct SimResult {
+    uint64_t games = 0;
+    uint64_t turns = 0;
+    uint64_t wins[MAX_PLAYERS] = {};
+    std::vector<uint64_t> length;    // games by number of turns
+    SimResult() : length(MAX_SIM_TURNS + 1) {}
+};
+
+// Play `games` games, SIM_LANES at once. Each lane is an independent
+// game; lanes that finish early are masked until the whole batch is done.
+void simulate(uint64_t games, int num_players, int goal, uint64_t seed, SimResult* out) {
+    LaneRng rng;
+    lane_rng_seed(&rng, seed);
+
+    for (uint64_t played = 0; played < games; played += SIM_LANES) {
+        int live = static_cast<int>(std::min<uint64_t>(SIM_LANES, games - played));
+
+        Lanes positions[MAX_PLAYERS] = {};
+        Lanes done = {};
+        for (int lane = live; lane < SIM_LANES; lane++) done[lane] = -1;
+
+        for (int turn = 1, seat = 0; !all_lanes(done); turn++, seat = race_next_seat(seat, num_players)) {
+            Lanes moved = race_advance(positions[seat], lane_dice(&rng));
+            positions[seat] = (moved & ~done) | (positions[seat] & done);
+
+            Lanes won = race_won(positions[seat], goal) & ~done;
+            if (!any_lane(won)) continue;
+
+            for (int lane = 0; lane < SIM_LANES; lane++) {
+                if (!won[lane]) continue;
+                out->wins[seat]++;
+                out->turns += turn;
+                out->length[std::min(turn, MAX_SIM_TURNS)]++;
+            }
+            done |= won;
+        }
+        out->games += live;
+    }
+}
+
+/* ========================================
+   REPORT
+   ======================================== */
+uint64_t length_percentile(const SimResult& r, double p) {
+    uint64_t rank = static_cast<uint64_t>(p / 100.0 * r.games);
+    uint64_t seen = 0;
+    for (int t = 0; t <= MAX_SIM_TURNS; t++) {
+        seen += r.length[t];
+        if (seen > rank) return t;
+    }
+    return MAX_SIM_TURNS;
+}
+
+void print_report(const SimResult& r, int num_players, int goal, double elapsed) {
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "=================================================\n";
+    std::cout << " SIMULATION: " << num_players << " players, goal " << goal << "m\n";
+    std::cout << "=================================================\n";
+    std::cout << " Games: " << r.games << " in " << elapsed << " s ("
+              << r.games / elapsed / 1e6 << "M games/s)\n\n";
+
+    std::cout << " Win probability by seat (Round Robin from seat 0):\n";
+    for (int seat = 0; seat < num_players; seat++) {
+        std::cout << "   Player " << seat << ": " << std::setw(6)
+                  << 100.0 * r.wins[seat] / r.games << " %\n";
+    }
+
+    std::cout << "\n Turns per game (rolls, = server load per game):\n";
+    std::cout << "   mean " << static_cast<double>(r.turns) / r.games
+              << "  p50 " << length_percentile(r, 50.0)
+              << "  p90 " << length_percentile(r, 90.0)
+              << "  p99 " << length_percentile(r, 99.0)
+              << "  p99.9 " << length_percentile(r, 99.9) << "\n";
+
+    std::cout << "\n Game length distribution:\n";
+    uint64_t peak = 0;
+    int first = MAX_SIM_TURNS, last = 0;
+    for (int t = 0; t <= MAX_SIM_TURNS; t++) {
+        if (!r.length[t]) continue;
+        peak = std::max(peak, r.length[t]);
+        first = std::min(first, t);
+        last = t;
+    }
+    for (int t = first; t <= last; t++) {
+        double share = 100.0 * r.length[t] / r.games;
+        if (share < 0.05) continue;
+        std::cout << "   " << std::setw(4) << t << " turns " << std::setw(6) << share << " % |"
+                  << std::string(static_cast<size_t>(50.0 * r.length[t] / peak), '#') << "\n";
+    }
+}
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [-p players] [-g goal] [-n games] [-T threads] [-s seed]\n"
+              << "  -p  players per table (default 3)\n"
+              << "  -g  winning position (default WIN_POSITION = " << WIN_POSITION << ")\n"
+              << "  -n  games to simulate (default 10000000)\n"
+              << "  -T  worker threads (default: one per CPU)\n"
+              << "  -s  seed (default 1), same seed and threads give the same result\n";
+}
+
+/* ========================================
+   MAIN
+   ======================================== */
+int main(int argc, char* argv[]) {
+    int num_players = 3;
+    int goal = WIN_POSITION;
+    uint64_t games = 10000000;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t seed = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "p:g:n:T:s:")) != -1) {
+        switch (opt) {
+        case 'p': num_players = atoi(optarg); break;
+        case 'g': goal = atoi(optarg); break;
+        case 'n': games = strtoull(optarg, nullptr, 0); break;
+        case 'T': threads = atoi(optarg); break;
+        case 's': seed = strtoull(optarg, nullptr, 0); break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+
+    if (num_players < 1 || num_players > MAX_PLAYERS || goal < 1 || games < 1 || threads < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<SimResult> results(threads);
+    std::vector<std::thread> workers;
+    long long start = monotonic_ns();
+
+    for (int t = 0; t < threads; t++) {
+        uint64_t share = games / threads + (static_cast<uint64_t>(t) < games % threads ? 1 : 0);
+        workers.emplace_back(simulate, share, num_players, goal,
+                             dice_mix(seed, t), &results[t]);
+    }
+    for (std::thread& worker : workers) worker.join();
+
+    double elapsed = (monotonic_ns() - start) / 1e9;
+
+    SimResult total;
+    for (const SimResult& r : results) {
+        total.games += r.games;
+        total.turns += r.turns;
+        for (int i = 0; i < MAX_PLAYERS; i++) total.wins[i] += r.wins[i];
+        for (int t = 0; t <= MAX_SIM_TURNS; t++) total.length[t] += r.length[t];
+    }
+
+    print_report(total, num_players, goal, elapsed);
+    return 0;
+}
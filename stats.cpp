@@ -0,0 +1,371 @@
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <string>
+
+#include "metrics.hpp"
+
+// Read-only view of the server's live metrics segment. Attaching never
+// takes a lock or writes to the segment, so it does not perturb the server.
+
+/* ========================================
+   SNAPSHOT
+   ======================================== */
+struct Snapshot {
+    double uptime_s;
+    int slots;
+    std::map<std::string, int> roles;    // role -> live slots
+
+    uint64_t turns;
+    LatencyHistogram handoff;
+    LatencyHistogram game_mutex_wait;
+    LatencyHistogram log_mutex_wait;
+    LatencyHistogram score_mutex_wait;
+
+    uint64_t broadcast_frames;
+    uint64_t broadcast_bytes;
+    uint64_t fifo_eagain;
+
+    uint64_t out_queued;
+    uint64_t out_partial;
+    uint64_t out_coalesced;
+    uint64_t out_depth;
+    uint64_t out_depth_max;
+    uint64_t out_stuck;
+
+    uint64_t log_written;
+    uint64_t log_batches;
+    uint64_t log_depth;
+    uint64_t log_depth_max;
+    uint64_t log_dropped;
+
+    uint64_t events_written;
+    uint64_t events_dropped;
+    uint64_t event_segment;
+
+    uint64_t score_events;
+    uint64_t score_commits;
+    LatencyHistogram score_commit;
+
+    uint64_t spectators;
+    uint64_t spectator_frames;
+    uint64_t spectator_bytes;
+    uint64_t spectator_coalesced;
+
+    uint64_t socket_joins;
+    uint64_t socket_rejoins;
+    uint64_t socket_leaves;
+    LatencyHistogram admission;
+
+    uint64_t handler_respawns;
+    uint64_t lock_repairs;
+
+    uint64_t deadlines_expired;
+    uint64_t deadline_rolls;
+    uint64_t deadline_skips;
+    uint64_t idle_seats;
+    uint64_t idle_returns;
+};
+
+uint64_t load(const uint64_t* counter) {
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+void merge(LatencyHistogram* into, const LatencyHistogram* from) {
+    for (int i = 0; i < HIST_BUCKETS; i++) into->counts[i] += load(&from->counts[i]);
+}
+
+void take_snapshot(const MetricsBlock* block, Snapshot* snap) {
+    *snap = Snapshot();
+
+    snap->uptime_s = (monotonic_ns() - block->start_ns) / 1e9;
+    snap->slots = std::min(block->num_slots.load(), MAX_METRIC_SLOTS);
+
+    for (int i = 0; i < snap->slots; i++) {
+        const MetricsSlot* slot = &block->slots[i];
+        if (__atomic_load_n(&slot->pid, __ATOMIC_ACQUIRE) == 0) continue;
+
+        if (!__atomic_load_n(&slot->released, __ATOMIC_ACQUIRE)) snap->roles[slot->role]++;
+        snap->turns += load(&slot->turns);
+        merge(&snap->handoff, &slot->handoff);
+        merge(&snap->game_mutex_wait, &slot->game_mutex_wait);
+        merge(&snap->log_mutex_wait, &slot->log_mutex_wait);
+        merge(&snap->score_mutex_wait, &slot->score_mutex_wait);
+
+        snap->broadcast_frames += load(&slot->broadcast_frames);
+        snap->broadcast_bytes += load(&slot->broadcast_bytes);
+        snap->fifo_eagain += load(&slot->fifo_eagain);
+
+        snap->out_queued += load(&slot->out_queued);
+        snap->out_partial += load(&slot->out_partial);
+        snap->out_coalesced += load(&slot->out_coalesced);
+        snap->out_depth += load(&slot->out_depth);
+        snap->out_depth_max = std::max(snap->out_depth_max, load(&slot->out_depth_max));
+        snap->out_stuck += load(&slot->out_stuck);
+
+        snap->log_written += load(&slot->log_written);
+        snap->log_batches += load(&slot->log_batches);
+        snap->log_depth += load(&slot->log_depth);
+        snap->log_depth_max = std::max(snap->log_depth_max, load(&slot->log_depth_max));
+        snap->log_dropped += load(&slot->log_dropped);
+
+        snap->events_written += load(&slot->events_written);
+        snap->events_dropped += load(&slot->events_dropped);
+        snap->event_segment = std::max(snap->event_segment, load(&slot->event_segment));
+
+        snap->score_events += load(&slot->score_events);
+        snap->score_commits += load(&slot->score_commits);
+        merge(&snap->score_commit, &slot->score_commit);
+
+        snap->spectators += load(&slot->spectators);
+        snap->spectator_frames += load(&slot->spectator_frames);
+        snap->spectator_bytes += load(&slot->spectator_bytes);
+        snap->spectator_coalesced += load(&slot->spectator_coalesced);
+
+        snap->socket_joins += load(&slot->socket_joins);
+        snap->socket_rejoins += load(&slot->socket_rejoins);
+        snap->socket_leaves += load(&slot->socket_leaves);
+        merge(&snap->admission, &slot->admission);
+
+        snap->handler_respawns += load(&slot->handler_respawns);
+        snap->lock_repairs += load(&slot->lock_repairs);
+
+        snap->deadlines_expired += load(&slot->deadlines_expired);
+        snap->deadline_rolls += load(&slot->deadline_rolls);
+        snap->deadline_skips += load(&slot->deadline_skips);
+        snap->idle_seats += load(&slot->idle_seats);
+        snap->idle_returns += load(&slot->idle_returns);
+    }
+}
+
+/* ========================================
+   OUTPUT
+   ======================================== */
+void print_hist(const char* name, const LatencyHistogram* h) {
+    std::cout << " " << std::left << std::setw(18) << name << std::right
+              << " n=" << std::setw(9) << hist_count(h)
+              << "  p50 " << std::setw(9) << hist_percentile(h, 50.0) / 1000.0 << " us"
+              << "  p99 " << std::setw(9) << hist_percentile(h, 99.0) / 1000.0 << " us"
+              << "  p99.9 " << std::setw(9) << hist_percentile(h, 99.9) / 1000.0 << " us\n";
+}
+
+void print_text(const Snapshot& s) {
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "=================================================\n";
+    std::cout << " SERVER METRICS (uptime " << s.uptime_s << " s)\n";
+    std::cout << "=================================================\n";
+    std::cout << " Slots:";
+    for (const auto& role : s.roles) std::cout << " " << role.first << "=" << role.second;
+    std::cout << "\n";
+    std::cout << " Turns: " << s.turns << " (" << s.turns / s.uptime_s << "/s)\n";
+    print_hist("turn handoff", &s.handoff);
+    print_hist("game_mutex wait", &s.game_mutex_wait);
+    print_hist("log_mutex wait", &s.log_mutex_wait);
+    print_hist("score_mutex wait", &s.score_mutex_wait);
+    std::cout << " Broadcast: " << s.broadcast_frames << " frames, "
+              << s.broadcast_bytes << " bytes, " << s.fifo_eagain << " found a full FIFO\n";
+    std::cout << " Outbound queues: " << s.out_queued << " frames queued, " << s.out_partial
+              << " partial writes finished, " << s.out_coalesced << " coalesced, depth "
+              << s.out_depth << " (max " << s.out_depth_max << "), " << s.out_stuck
+              << " stuck clients\n";
+    std::cout << " Log: " << s.log_written << " written in " << s.log_batches
+              << " batches, queue depth " << s.log_depth << " (max " << s.log_depth_max
+              << "), " << s.log_dropped << " dropped\n";
+    std::cout << " Events: " << s.events_written << " written to segment " << s.event_segment
+              << ", " << s.events_dropped << " dropped\n";
+    std::cout << " Scores: " << s.score_events << " wins journaled in "
+              << s.score_commits << " group commits\n";
+    print_hist("score commit", &s.score_commit);
+    std::cout << " Spectators: " << s.spectators << " attached, " << s.spectator_frames
+              << " frames, " << s.spectator_bytes << " bytes, "
+              << s.spectator_coalesced << " coalesced\n";
+    std::cout << " Socket players: " << s.socket_joins << " joins, " << s.socket_rejoins
+              << " rejoins, " << s.socket_leaves << " leaves\n";
+    print_hist("admission", &s.admission);
+    std::cout << " Crash recovery: " << s.handler_respawns << " handler respawns, "
+              << s.lock_repairs << " lock repairs\n";
+    std::cout << " Turn deadlines: " << s.deadlines_expired << " expired ("
+              << s.deadline_rolls << " rolled for, " << s.deadline_skips << " skipped), "
+              << s.idle_seats << " seats idled, " << s.idle_returns << " returned\n";
+}
+
+void print_json_hist(const char* name, const LatencyHistogram* h) {
+    std::cout << "\"" << name << "\":{\"count\":" << hist_count(h)
+              << ",\"p50_ns\":" << hist_percentile(h, 50.0)
+              << ",\"p99_ns\":" << hist_percentile(h, 99.0)
+              << ",\"p999_ns\":" << hist_percentile(h, 99.9) << "}";
+}
+
+void print_json(const Snapshot& s) {
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "{\"uptime_s\":" << s.uptime_s << ",\"slots\":{";
+    bool first = true;
+    for (const auto& role : s.roles) {
+        std::cout << (first ? "" : ",") << "\"" << role.first << "\":" << role.second;
+        first = false;
+    }
+    std::cout << "},\"turns\":" << s.turns << ",";
+    print_json_hist("turn_handoff", &s.handoff);
+    std::cout << ",";
+    print_json_hist("game_mutex_wait", &s.game_mutex_wait);
+    std::cout << ",";
+    print_json_hist("log_mutex_wait", &s.log_mutex_wait);
+    std::cout << ",";
+    print_json_hist("score_mutex_wait", &s.score_mutex_wait);
+    std::cout << ",\"broadcast_frames\":" << s.broadcast_frames
+              << ",\"broadcast_bytes\":" << s.broadcast_bytes
+              << ",\"fifo_eagain\":" << s.fifo_eagain
+              << ",\"out_queued\":" << s.out_queued
+              << ",\"out_partial\":" << s.out_partial
+              << ",\"out_coalesced\":" << s.out_coalesced
+              << ",\"out_depth\":" << s.out_depth
+              << ",\"out_depth_max\":" << s.out_depth_max
+              << ",\"out_stuck\":" << s.out_stuck
+              << ",\"log_written\":" << s.log_written
+              << ",\"log_batches\":" << s.log_batches
+              << ",\"log_depth\":" << s.log_depth
+              << ",\"log_depth_max\":" << s.log_depth_max
+              << ",\"log_dropped\":" << s.log_dropped
+              << ",\"events_written\":" << s.events_written
+              << ",\"events_dropped\":" << s.events_dropped
+              << ",\"event_segment\":" << s.event_segment
+              << ",\"score_events\":" << s.score_events
+              << ",\"score_commits\":" << s.score_commits << ",";
+    print_json_hist("score_commit", &s.score_commit);
+    std::cout << ",\"spectators\":" << s.spectators
+              << ",\"spectator_frames\":" << s.spectator_frames
+              << ",\"spectator_bytes\":" << s.spectator_bytes
+              << ",\"spectator_coalesced\":" << s.spectator_coalesced
+              << ",\"socket_joins\":" << s.socket_joins
+              << ",\"socket_rejoins\":" << s.socket_rejoins
+              << ",\"socket_leaves\":" << s.socket_leaves << ",";
+    print_json_hist("admission", &s.admission);
+    std::cout << ",\"handler_respawns\":" << s.handler_respawns
+              << ",\"lock_repairs\":" << s.lock_repairs
+              << ",\"deadlines_expired\":" << s.deadlines_expired
+              << ",\"deadline_rolls\":" << s.deadline_rolls
+              << ",\"deadline_skips\":" << s.deadline_skips
+              << ",\"idle_seats\":" << s.idle_seats
+              << ",\"idle_returns\":" << s.idle_returns << "}\n";
+}
+
+// Per-table game state, read through the seqlock snapshots: the tool
+// maps the segments read-only and never takes a game_mutex.
+void print_tables() {
+    int shm_fd = shm_open(SHM_NAME, O_RDONLY, 0);
+    int tables_fd = shm_open(TABLES_SHM_NAME, O_RDONLY, 0);
+    if (shm_fd < 0 || tables_fd < 0) {
+        perror("shm_open tables");
+        if (shm_fd >= 0) close(shm_fd);
+        return;
+    }
+
+    void* control = mmap(nullptr, sizeof(SharedData), PROT_READ, MAP_SHARED, shm_fd, 0);
+    close(shm_fd);
+    if (control == MAP_FAILED) {
+        perror("mmap control");
+        close(tables_fd);
+        return;
+    }
+
+    const SharedData* shared = static_cast<const SharedData*>(control);
+    if (shared->magic != SHM_MAGIC || shared->version != SHM_VERSION ||
+        shared->table_size != sizeof(Table)) {
+        std::cerr << "Shared memory layout does not match this build\n";
+        munmap(control, sizeof(SharedData));
+        close(tables_fd);
+        return;
+    }
+    int num_tables = __atomic_load_n(&shared->num_tables, __ATOMIC_ACQUIRE);
+    int restarts = shared->restarts;
+    munmap(control, sizeof(SharedData));
+
+    size_t size = sizeof(Table) * num_tables;
+    void* mapped = size ? mmap(nullptr, size, PROT_READ, MAP_SHARED, tables_fd, 0) : MAP_FAILED;
+    close(tables_fd);
+    if (mapped == MAP_FAILED) {
+        perror("mmap tables");
+        return;
+    }
+
+    const Table* tables = static_cast<const Table*>(mapped);
+    std::cout << " Warm restarts: " << restarts << "\n";
+    std::cout << " Table  version  turn  state     positions\n";
+    for (int t = 0; t < num_tables; t++) {
+        GameState game;
+        uint32_t version = table_snapshot(&tables[t], &game);
+
+        const char* state = game.game_over ? "over" : game.game_active ? "playing" : "waiting";
+        std::cout << " " << std::setw(5) << t << std::setw(9) << version / 2
+                  << std::setw(6) << game.current_turn << "  " << std::left << std::setw(9)
+                  << state << std::right;
+        for (int i = 0; i < game.num_players; i++) std::cout << " " << std::setw(3) << game.positions[i];
+        std::cout << "\n";
+    }
+
+    munmap(mapped, size);
+}
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [-j] [-t] [-i seconds]\n"
+              << "  -j  print a JSON snapshot instead of text\n"
+              << "  -t  also print every table's game state (lock-free snapshots)\n"
+              << "  -i  repeat every N seconds until interrupted\n";
+}
+
+/* ========================================
+   MAIN
+   ======================================== */
+int main(int argc, char* argv[]) {
+    bool json = false;
+    bool tables = false;
+    int interval = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "jti:")) != -1) {
+        switch (opt) {
+        case 'j': json = true; break;
+        case 't': tables = true; break;
+        case 'i': interval = atoi(optarg); break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+
+    int fd = shm_open(METRICS_SHM_NAME, O_RDONLY, 0);
+    if (fd < 0) {
+        perror("shm_open metrics (is the server running?)");
+        return 1;
+    }
+
+    void* mapped = mmap(nullptr, sizeof(MetricsBlock), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        perror("mmap metrics");
+        return 1;
+    }
+
+    const MetricsBlock* block = static_cast<const MetricsBlock*>(mapped);
+    if (block->magic != METRICS_MAGIC || block->version != METRICS_VERSION) {
+        std::cerr << "Metrics segment has an unknown layout\n";
+        return 1;
+    }
+
+    Snapshot snap;
+    while (true) {
+        take_snapshot(block, &snap);
+        if (json) print_json(snap);
+        else print_text(snap);
+        if (tables) print_tables();
+
+        if (interval <= 0) break;
+        sleep(interval);
+    }
+
+    munmap(mapped, sizeof(MetricsBlock));
+    return 0;
+}
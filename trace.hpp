@@ -0,0 +1,237 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+#include "common.hpp"
+
+// ---- Turn tracing ----
+// Opt-in (server -T file). A separate shared-memory segment of span
+// buffers, one per handler process or server thread, each with a single
+// writer like the metrics slots. A span is written into the next entry of
+// the owner's ring and published by bumping the ring's count, so
+// recording never takes a lock or a syscall besides the clock reads.
+// Buffers outlive the handler that filled them; the server merges all of
+// them into one Chrome trace-event JSON file (trace_write) on shutdown or
+// SIGUSR1, which opens in Perfetto (ui.perfetto.dev) or chrome://tracing.
+//
+// With tracing off no segment exists and t_trace stays null: every
+// instrumentation point is one thread-local load and a branch.
+constexpr const char* TRACE_SHM_NAME = "/race_game_trace";
+constexpr uint32_t TRACE_MAGIC = 0x43525452;   // "RTRC"
+constexpr uint32_t TRACE_VERSION = 1;
+constexpr int MAX_TRACE_BUFFERS = 1024;
+constexpr int TRACE_NAME_LEN = 24;
+constexpr long long TRACE_LOCK_MIN_NS = 1000;  // shorter game_mutex waits are not traced
+#ifndef TRACE_BUFFER_SPANS
+#define TRACE_BUFFER_SPANS 8192                // per buffer, the oldest are overwritten
+#endif
+
+enum TraceType : uint16_t {
+    TR_TURN_WAIT  = 1,   // handler asleep until its turn (other seats' turns)
+    TR_PROMPT     = 2,   // YOUR_TURN sent
+    TR_ROLL_WAIT  = 3,   // YOUR_TURN sent -> ROLL received (the player thinking)
+    TR_COMMIT     = 4,   // position committed under game_mutex, arg = dice
+    TR_BROADCAST  = 5,   // STATE frame(s) rendered and written
+    TR_ANNOUNCE   = 6,   // console, game.log, event log and score for a roll
+    TR_LOCK_WAIT  = 7,   // contended game_mutex acquisition
+    TR_SCHEDULE   = 8,   // scheduler advanced a table's turn, arg = next seat
+    TR_LOG_FLUSH  = 9,   // logger wrote a batch, arg = lines and records
+    TR_PLAY       = 10,  // reactor: ROLL received -> next prompt, arg = dice
+};
+
+struct TraceSpan {
+    int64_t start_ns;    // CLOCK_MONOTONIC
+    int64_t dur_ns;
+    int32_t table;       // -1: not about one table
+    int16_t seat;        // -1: not about one seat
+    uint16_t type;       // TraceType
+    uint32_t arg;
+    uint32_t reserved;
+};
+static_assert(sizeof(TraceSpan) == 32, "trace spans are 32 bytes");
+
+struct alignas(64) TraceBuffer {
+    int pid;
+    int tid;
+    char name[TRACE_NAME_LEN];           // "handler 3.1", "scheduler", ...
+    std::atomic<uint64_t> count;         // spans recorded; the last TRACE_BUFFER_SPANS are kept
+    alignas(64) TraceSpan spans[TRACE_BUFFER_SPANS];
+};
+
+struct TraceBlock {
+    uint32_t magic;
+    uint32_t version;
+    long long start_ns;                  // trace time 0
+    int server_pid;                      // its threads are one process in the trace
+    std::atomic<int> num_buffers;        // claimed so far, may pass MAX_TRACE_BUFFERS
+    TraceBuffer buffers[MAX_TRACE_BUFFERS];
+};
+
+// Mapped by the server when tracing is on, inherited by forked handlers
+inline TraceBlock* g_trace = nullptr;
+inline thread_local TraceBuffer* t_trace = nullptr;
+
+// Claim a buffer for the calling thread (call again in a forked child,
+// which would otherwise keep writing into its parent thread's buffer)
+inline void trace_attach(const char* name) {
+    t_trace = nullptr;
+    if (!g_trace) return;
+
+    int index = g_trace->num_buffers.fetch_add(1);
+    if (index >= MAX_TRACE_BUFFERS) return;
+
+    TraceBuffer* buffer = &g_trace->buffers[index];
+    snprintf(buffer->name, TRACE_NAME_LEN, "%s", name);
+    buffer->tid = static_cast<int>(syscall(SYS_gettid));
+    __atomic_store_n(&buffer->pid, getpid(), __ATOMIC_RELEASE);
+    t_trace = buffer;
+}
+
+// Start of a span: 0 (and no clock read) when this thread is not traced
+inline long long trace_begin() {
+    return t_trace ? monotonic_ns() : 0;
+}
+
+// Record the span that began at `start` (from trace_begin) and ends now.
+// Spans of one thread must nest or follow each other.
+inline void trace_end(TraceType type, long long start, int table = -1, int seat = -1,
+                      uint32_t arg = 0, long long min_ns = 0) {
+    TraceBuffer* buffer = t_trace;
+    if (!buffer || !start) return;
+    long long dur = monotonic_ns() - start;
+    if (dur < min_ns) return;
+
+    uint64_t n = buffer->count.load(std::memory_order_relaxed);
+    TraceSpan& span = buffer->spans[n % TRACE_BUFFER_SPANS];
+    span.start_ns = start;
+    span.dur_ns = dur;
+    span.table = table;
+    span.seat = static_cast<int16_t>(seat);
+    span.type = type;
+    span.arg = arg;
+    buffer->count.store(n + 1, std::memory_order_release);
+}
+
+inline const char* trace_type_name(uint16_t type) {
+    switch (type) {
+    case TR_TURN_WAIT: return "turn wait";
+    case TR_PROMPT:    return "prompt";
+    case TR_ROLL_WAIT: return "roll wait";
+    case TR_COMMIT:    return "commit";
+    case TR_BROADCAST: return "broadcast";
+    case TR_ANNOUNCE:  return "announce";
+    case TR_LOCK_WAIT: return "game_mutex wait";
+    case TR_SCHEDULE:  return "schedule";
+    case TR_LOG_FLUSH: return "log flush";
+    case TR_PLAY:      return "play";
+    default:           return "unknown";
+    }
+}
+
+// Name of TraceSpan::arg in the JSON, or null when it carries nothing
+inline const char* trace_arg_name(uint16_t type) {
+    switch (type) {
+    case TR_COMMIT:
+    case TR_PLAY:      return "dice";
+    case TR_SCHEDULE:  return "next";
+    case TR_LOG_FLUSH: return "written";
+    default:           return nullptr;
+    }
+}
+
+// ---- Export (server main thread) ----
+struct TraceEntry {
+    TraceSpan span;
+    int buffer;
+};
+
+// Merge every buffer into a trace-event JSON file: one "X" (complete)
+// event per span, in time order, with process and thread names. Writers
+// keep going meanwhile; a span that may have been overwritten while it
+// was copied is left out. Returns the number of spans written, -1 on error.
+inline long trace_write(const TraceBlock* block, const char* path) {
+    int buffers = std::min(block->num_buffers.load(), MAX_TRACE_BUFFERS);
+    std::vector<TraceEntry> entries;
+    for (int b = 0; b < buffers; b++) {
+        const TraceBuffer& buffer = block->buffers[b];
+        if (__atomic_load_n(&buffer.pid, __ATOMIC_ACQUIRE) == 0) continue;
+
+        uint64_t end = buffer.count.load(std::memory_order_acquire);
+        uint64_t begin = end > TRACE_BUFFER_SPANS ? end - TRACE_BUFFER_SPANS : 0;
+        size_t first = entries.size();
+        for (uint64_t n = begin; n < end; n++)
+            entries.push_back({ buffer.spans[n % TRACE_BUFFER_SPANS], b });
+
+        // Entries the writer has reached again since we read `end` may be torn
+        uint64_t now = buffer.count.load(std::memory_order_acquire);
+        uint64_t safe = now + 1 > TRACE_BUFFER_SPANS ? now + 1 - TRACE_BUFFER_SPANS : 0;
+        uint64_t lapped = safe > begin ? std::min<uint64_t>(safe - begin, end - begin) : 0;
+        entries.erase(entries.begin() + first, entries.begin() + first + lapped);
+    }
+    std::sort(entries.begin(), entries.end(), [](const TraceEntry& a, const TraceEntry& b) {
+        return a.span.start_ns < b.span.start_ns;
+    });
+
+    FILE* out = fopen(path, "w");
+    if (!out) {
+        perror(path);
+        return -1;
+    }
+
+    // Server threads share one process; a handler is a process of its own,
+    // named after its seat
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+                 "\"args\":{\"name\":\"server\"}}",
+            block->server_pid);
+    for (int b = 0; b < buffers; b++) {
+        const TraceBuffer& buffer = block->buffers[b];
+        if (buffer.pid == 0) continue;
+        if (buffer.pid != block->server_pid)
+            fprintf(out, ",\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+                         "\"args\":{\"name\":\"%s\"}}",
+                    buffer.pid, buffer.name);
+        fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                     "\"args\":{\"name\":\"%s\"}}",
+                buffer.pid, buffer.tid, buffer.name);
+    }
+
+    for (const TraceEntry& entry : entries) {
+        const TraceSpan& span = entry.span;
+        const TraceBuffer& buffer = block->buffers[entry.buffer];
+        fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"turn\",\"ph\":\"X\",\"ts\":%.3f,"
+                     "\"dur\":%.3f,\"pid\":%d,\"tid\":%d,\"args\":{",
+                trace_type_name(span.type),
+                (span.start_ns - block->start_ns) / 1e3, span.dur_ns / 1e3,
+                buffer.pid, buffer.tid);
+        const char* sep = "";
+        if (span.table >= 0) {
+            fprintf(out, "\"table\":%d", span.table);
+            sep = ",";
+        }
+        if (span.seat >= 0) {
+            fprintf(out, "%s\"seat\":%d", sep, span.seat);
+            sep = ",";
+        }
+        if (const char* arg = trace_arg_name(span.type))
+            fprintf(out, "%s\"%s\":%u", sep, arg, span.arg);
+        fprintf(out, "}}");
+    }
+    fprintf(out, "\n]}\n");
+
+    if (fclose(out) != 0) {
+        perror(path);
+        return -1;
+    }
+    return static_cast<long>(entries.size());
+}
+
+#endif